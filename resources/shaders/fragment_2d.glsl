@@ -1,15 +1,39 @@
 #version 330 core
 in vec2 fragUV;
 in vec4 fragColor;
+flat in int fragTexIndex;
 
-uniform sampler2D texture0;
-uniform int useTexture;
+// One per texture slot of the batch (Renderer2D::MAX_TEXTURE_SLOTS)
+uniform sampler2D textures[16];
 
 out vec4 outColor;
 
+// GLSL 3.30 only allows indexing sampler arrays with constants, hence the switch
+vec4 sampleSlot(int slot, vec2 uv) {
+    switch (slot) {
+        case 0: return texture(textures[0], uv);
+        case 1: return texture(textures[1], uv);
+        case 2: return texture(textures[2], uv);
+        case 3: return texture(textures[3], uv);
+        case 4: return texture(textures[4], uv);
+        case 5: return texture(textures[5], uv);
+        case 6: return texture(textures[6], uv);
+        case 7: return texture(textures[7], uv);
+        case 8: return texture(textures[8], uv);
+        case 9: return texture(textures[9], uv);
+        case 10: return texture(textures[10], uv);
+        case 11: return texture(textures[11], uv);
+        case 12: return texture(textures[12], uv);
+        case 13: return texture(textures[13], uv);
+        case 14: return texture(textures[14], uv);
+        case 15: return texture(textures[15], uv);
+    }
+    return vec4(1.0);
+}
+
 void main() {
-    if (useTexture == 1)
-        outColor = texture(texture0, fragUV) * fragColor;
+    if (fragTexIndex >= 0)
+        outColor = sampleSlot(fragTexIndex, fragUV) * fragColor;
     else
         outColor = fragColor;
-}
\ No newline at end of file
+}
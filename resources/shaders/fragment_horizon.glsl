@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+in float Distance;
+in vec2 Offset;
+
+// Horizontal distances this level is responsible for: [x, y)
+uniform vec2 ringRange;
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 screen; // Pixel space, origin top left
+    vec4 cameraPosition;
+    vec4 fogColor;
+    vec4 fogParams; // x = fog distance
+};
+
+void main()
+{
+    float ring = length(Offset);
+    if (ring < ringRange.x || ring >= ringRange.y)
+        discard;
+
+    // Same fog as fragment_texture.glsl so the horizon meets the chunks without a seam
+    float fog = min(1.0f, Distance / fogParams.x);
+    FragColor = vec4(mix(Color, fogColor.rgb, fog * fog), 1.0f);
+}
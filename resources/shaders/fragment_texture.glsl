@@ -7,8 +7,16 @@ in float Distance;
 uniform sampler2D texture0;
 uniform sampler2D normalMap;
 uniform float normalStrength = 0.2;
-uniform vec3 SkyColor = vec3(186.0f / 255.0f, 214.0f / 255.0f, 254.0f / 255.0f);
-uniform float fogMax = 2000.0f;
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 screen; // Pixel space, origin top left
+    vec4 cameraPosition;
+    vec4 fogColor;
+    vec4 fogParams; // x = fog distance
+};
 
 void main()
 {
@@ -18,5 +26,7 @@ void main()
         discard;
 
 
-    FragColor = vec4(mix(texColor.xyz, SkyColor, min(1.0f, Distance / fogMax)), texColor.w);
+    // Quadratic falloff keeps the near field clear and thickens towards the fog distance
+    float fog = min(1.0f, Distance / fogParams.x);
+    FragColor = vec4(mix(texColor.xyz, fogColor.rgb, fog * fog), texColor.w);
 }
\ No newline at end of file
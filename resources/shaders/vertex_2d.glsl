@@ -2,14 +2,26 @@
 layout(location = 0) in vec2 inPos;
 layout(location = 1) in vec2 inUV;
 layout(location = 2) in vec4 inColor;
+layout(location = 3) in int inTexIndex;
 
-uniform mat4 projection;
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 screen; // Pixel space, origin top left
+    vec4 cameraPosition;
+    vec4 fogColor;
+    vec4 fogParams; // x = fog distance
+};
 
 out vec2 fragUV;
 out vec4 fragColor;
+flat out int fragTexIndex;
 
 void main() {
     fragUV = inUV;
     fragColor = inColor;
-    gl_Position = projection * vec4(inPos, -0.999, 1.0);
+    fragTexIndex = inTexIndex;
+    gl_Position = screen * vec4(inPos, -0.999, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 Color;
+out float Distance;
+out vec2 Offset; // Horizontal offset from the camera, for the level's ring test
+
+// Far-plane projection for the horizon pass; see HorizonRenderer::draw
+uniform mat4 farProjection;
+
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 screen; // Pixel space, origin top left
+	vec4 cameraPosition;
+	vec4 fogColor;
+	vec4 fogParams; // x = fog distance
+};
+
+void main()
+{
+	gl_Position = farProjection * view * vec4(aPos, 1.0);
+	Color = aColor;
+	Distance = length(aPos - cameraPosition.xyz);
+	Offset = aPos.xz - cameraPosition.xz;
+}
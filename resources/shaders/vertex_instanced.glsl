@@ -0,0 +1,28 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+
+out vec2 TexCoord;
+out float Distance;
+
+layout (location = 3) in mat4 aModel; // Per instance, locations 3-6
+
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 screen; // Pixel space, origin top left
+	vec4 cameraPosition;
+	vec4 fogColor;
+	vec4 fogParams; // x = fog distance
+};
+
+void main()
+{
+	gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+
+	// World-space distance from the eye, so fog ends where the world does however far that is
+	Distance = length((aModel * vec4(aPos, 1.0)).xyz - cameraPosition.xyz);
+}
\ No newline at end of file
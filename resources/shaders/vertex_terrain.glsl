@@ -0,0 +1,33 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in uint aDrawIndex; // Per-instance; equals the draw's baseInstance
+
+// World-space origin of every chunk in this multi-draw, indexed by aDrawIndex
+layout (std430, binding = 0) readonly buffer ChunkOrigins
+{
+	vec4 origins[];
+};
+
+out vec2 TexCoord;
+out float Distance;
+
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 screen; // Pixel space, origin top left
+	vec4 cameraPosition;
+	vec4 fogColor;
+	vec4 fogParams; // x = fog distance
+};
+
+void main()
+{
+	gl_Position = projection * view * vec4(aPos + origins[aDrawIndex].xyz, 1.0);
+	TexCoord = aTexCoord;
+
+	// Same fog distance as vertex_texture.glsl
+	Distance = length(aPos + origins[aDrawIndex].xyz - cameraPosition.xyz);
+}
\ No newline at end of file
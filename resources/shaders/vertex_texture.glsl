@@ -6,18 +6,23 @@ out vec2 TexCoord;
 out float Distance;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Per-frame camera data shared by every shader (std140, see CameraUniforms in renderer.h)
+layout (std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 screen; // Pixel space, origin top left
+	vec4 cameraPosition;
+	vec4 fogColor;
+	vec4 fogParams; // x = fog distance
+};
 
 void main()
 {
 	gl_Position = projection * view * model * vec4(aPos, 1.0);
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
 
-	// Makes no sense but it works
-	Distance = (
-		gl_Position.x * gl_Position.x + 
-		gl_Position.y * gl_Position.y + 
-		gl_Position.z * gl_Position.z
-	);
+	// World-space distance from the eye, so fog ends where the world does however far that is
+	Distance = length((model * vec4(aPos, 1.0)).xyz - cameraPosition.xyz);
 }
\ No newline at end of file
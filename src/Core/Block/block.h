@@ -6,13 +6,12 @@
 #include <array>
 #include <glm/glm.hpp>
 #include "../transform.h"
-#include "../Rendering/meshRenderer.h"
 #include "../object.h"
 #include "../Rendering/mesh.h"
-#include "../Rendering/texture.h"
-#include "../atlas.h"
 #include "../Util/vertex.h"
 
+class TextureAtlas; // Only passed through; its header needs GL
+
 
 enum BlockType
 {
@@ -23,6 +22,18 @@ enum BlockType
     BLOCK_TYPE_AIR,
 };
 
+// Whether the block occupies its cell at all (collision, heightmaps)
+inline bool isBlockSolid(BlockType type)
+{
+    return type != BLOCK_TYPE_AIR;
+}
+
+// Whether the block hides what is behind it; every solid block is opaque for now
+inline bool isBlockOpaque(BlockType type)
+{
+    return isBlockSolid(type);
+}
+
 enum BlockFace
 {
     BLOCK_FACE_TOP,
@@ -32,6 +43,15 @@ enum BlockFace
     BLOCK_FACE_FRONT,
     BLOCK_FACE_BACK
 };
+static const int BLOCK_FACE_COUNT = 6;
+
+// Unit step from a block to the neighbour that shares the face
+inline glm::ivec3 getBlockFaceNormal(int face)
+{
+    static const glm::ivec3 normals[BLOCK_FACE_COUNT] = {
+        {0, 1, 0}, {0, -1, 0}, {-1, 0, 0}, {1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+    return normals[face];
+}
 
 
 
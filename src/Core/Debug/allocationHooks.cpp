@@ -0,0 +1,26 @@
+#include <cstdlib>
+#include <new>
+#include "allocationTracker.h"
+
+// The game's global allocation functions: malloc and free as before, plus a count per
+// AllocationTracker tag. The game and voxelc_bench link this file; pregen keeps the defaults.
+
+// GCC inlines these into the standard containers and then flags the malloc/free pair
+// as mismatched with the operator new it can no longer see
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size)
+{
+    AllocationTracker::record(size);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { operator delete(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { operator delete(memory); }
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <atomic>
+#include "allocationTracker.h"
+
+namespace
+{
+    // Nothing here may allocate: it runs inside operator new, possibly before main
+    struct alignas(64) ThreadCounters
+    {
+        std::atomic<std::uint64_t> bytes[ALLOC_TAG_COUNT];
+        std::atomic<std::uint64_t> count[ALLOC_TAG_COUNT];
+    };
+
+    ThreadCounters counters[AllocationTracker::MAX_THREADS + 1]; // The last one is shared
+    std::atomic<int> nextSlot{0};
+    thread_local int slot = -1;
+    thread_local AllocationTag currentTag = ALLOC_OTHER;
+
+    // Slots are never handed back; a thread's totals stay counted after it exits
+    int getSlot()
+    {
+        if (slot < 0)
+            slot = std::min(nextSlot.fetch_add(1, std::memory_order_relaxed), AllocationTracker::MAX_THREADS);
+        return slot;
+    }
+}
+
+void AllocationTracker::record(std::size_t bytes)
+{
+    int index = getSlot();
+    ThreadCounters &own = counters[index];
+    if (index == MAX_THREADS)
+    {
+        own.bytes[currentTag].fetch_add(bytes, std::memory_order_relaxed);
+        own.count[currentTag].fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Only this thread writes its slot, so a plain add does without the locked instruction
+    own.bytes[currentTag].store(own.bytes[currentTag].load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    own.count[currentTag].store(own.count[currentTag].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+AllocationTag AllocationTracker::getTag() { return currentTag; }
+
+void AllocationTracker::setTag(AllocationTag tag) { currentTag = tag; }
+
+std::uint64_t AllocationTracker::getBytes(AllocationTag tag)
+{
+    std::uint64_t total = 0;
+    for (const auto &thread : counters)
+        total += thread.bytes[tag].load(std::memory_order_relaxed);
+    return total;
+}
+
+std::uint64_t AllocationTracker::getCount(AllocationTag tag)
+{
+    std::uint64_t total = 0;
+    for (const auto &thread : counters)
+        total += thread.count[tag].load(std::memory_order_relaxed);
+    return total;
+}
+
+const char *AllocationTracker::getTagName(AllocationTag tag)
+{
+    switch (tag)
+    {
+    case ALLOC_WORLD:
+        return "world";
+    case ALLOC_MESH:
+        return "mesh";
+    case ALLOC_RENDER:
+        return "render";
+    default:
+        return "other";
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// What a thread is doing when it allocates; heap use is charged to it
+enum AllocationTag
+{
+    ALLOC_OTHER,
+    ALLOC_WORLD,  // Generation, streaming and chunk bookkeeping
+    ALLOC_MESH,   // Building chunk meshes
+    ALLOC_RENDER, // Draw submission, uploads and UI
+    ALLOC_TAG_COUNT
+};
+
+// Heap bytes and allocations made so far, per tag. The game and voxelc_bench replace
+// operator new to feed it (allocationHooks.cpp); pregen doesn't and reads zero everywhere.
+// Every thread counts into a slot of its own, so recording never contends; only
+// frees aren't tracked, as they'd need the size and tag stored with every block.
+class AllocationTracker
+{
+public:
+    static constexpr int MAX_THREADS = 64; // Later threads share one contended slot
+
+    // Called from operator new: charges the calling thread's current tag
+    static void record(std::size_t bytes);
+
+    static AllocationTag getTag();
+    static void setTag(AllocationTag tag);
+
+    // Sum over every thread so far; safe from any thread
+    static std::uint64_t getBytes(AllocationTag tag);
+    static std::uint64_t getCount(AllocationTag tag);
+
+    static const char *getTagName(AllocationTag tag);
+};
+
+// Charges the calling thread's allocations to `tag` until the end of the block
+class AllocationScope
+{
+public:
+    explicit AllocationScope(AllocationTag tag) : previous(AllocationTracker::getTag()) { AllocationTracker::setTag(tag); }
+    ~AllocationScope() { AllocationTracker::setTag(previous); }
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+    AllocationTag previous;
+};
+
+#endif // ALLOCATION_TRACKER_H
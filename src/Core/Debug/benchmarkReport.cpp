@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include "benchmarkReport.h"
+
+namespace
+{
+    std::string escapeJson(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string formatValue(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        return text;
+    }
+
+    bool endsWith(const std::string &text, const std::string &suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+void BenchmarkReport::addFrame(const FrameProfiler &profiler, std::size_t loadedChunks, std::size_t visibleChunks,
+                               const RenderStats &stats)
+{
+    double ms = profiler.getLastFrameMs();
+    if (ms < 0.0)
+        return; // No whole frame behind it yet
+
+    const auto &stages = profiler.getStages();
+    if (stageNames.empty())
+    {
+        for (const auto &stage : stages)
+            stageNames.push_back(stage.name);
+        stageMs.resize(stages.size());
+    }
+    for (std::size_t i = 0; i < stages.size() && i < stageMs.size(); i++)
+        stageMs[i].push_back(stages[i].lastMs);
+
+    frameMs.push_back(ms);
+    for (int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+    {
+        if (stats.gpuMs[pass] >= 0.0)
+            gpuMs[pass].push_back(stats.gpuMs[pass]);
+    }
+    this->loadedChunks.push_back(static_cast<double>(loadedChunks));
+    this->visibleChunks.push_back(static_cast<double>(visibleChunks));
+    drawCalls.push_back(static_cast<double>(stats.counters.drawCalls));
+    triangles.push_back(static_cast<double>(stats.counters.triangles));
+}
+
+BenchmarkReport::Distribution BenchmarkReport::summarize(std::vector<double> values)
+{
+    Distribution result;
+    if (values.empty())
+        return result;
+    std::sort(values.begin(), values.end());
+    // Nearest-rank percentiles, so every reported value is a frame that happened
+    auto percentile = [&values](double p) {
+        std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+    };
+    result.average = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    result.p50 = percentile(50.0);
+    result.p95 = percentile(95.0);
+    result.p99 = percentile(99.0);
+    result.max = values.back();
+    return result;
+}
+
+std::vector<std::pair<std::string, double>> BenchmarkReport::getMetrics() const
+{
+    std::vector<std::pair<std::string, double>> metrics;
+    auto addDistribution = [&metrics](const std::string &name, const std::vector<double> &values) {
+        Distribution d = summarize(values);
+        metrics.push_back({name + ".avg", d.average});
+        metrics.push_back({name + ".p50", d.p50});
+        metrics.push_back({name + ".p95", d.p95});
+        metrics.push_back({name + ".p99", d.p99});
+        metrics.push_back({name + ".max", d.max});
+    };
+
+    double totalMs = std::accumulate(frameMs.begin(), frameMs.end(), 0.0);
+    metrics.push_back({"frames", static_cast<double>(frameMs.size())});
+    metrics.push_back({"seconds", totalMs / 1000.0});
+    metrics.push_back({"fps.avg", totalMs > 0.0 ? frameMs.size() * 1000.0 / totalMs : 0.0});
+    addDistribution("frame_ms", frameMs);
+    for (std::size_t i = 0; i < stageNames.size(); i++)
+        addDistribution("stage_ms." + stageNames[i], stageMs[i]);
+    for (int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+        addDistribution(std::string("gpu_ms.") + getRenderPassName(static_cast<RenderPass>(pass)), gpuMs[pass]);
+
+    Distribution loaded = summarize(loadedChunks);
+    Distribution visible = summarize(visibleChunks);
+    metrics.push_back({"chunks.loaded.avg", loaded.average});
+    metrics.push_back({"chunks.loaded.max", loaded.max});
+    metrics.push_back({"chunks.loaded.final", loadedChunks.empty() ? 0.0 : loadedChunks.back()});
+    metrics.push_back({"chunks.visible.avg", visible.average});
+    metrics.push_back({"chunks.visible.max", visible.max});
+    metrics.push_back({"draws.avg", summarize(drawCalls).average});
+    metrics.push_back({"triangles.avg", summarize(triangles).average});
+    return metrics;
+}
+
+bool BenchmarkReport::write(const std::string &path, const BenchmarkInfo &info) const
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    auto metrics = getMetrics();
+    if (endsWith(path, ".csv"))
+    {
+        out << "metric,value\n";
+        out << "path," << info.pathName << "\n";
+        out << "seed," << info.seed << "\n";
+        out << "width," << info.width << "\n";
+        out << "height," << info.height << "\n";
+        out << "render_distance," << formatValue(info.renderDistance) << "\n";
+        out << "occlusion_culling," << (info.occlusionCulling ? "on" : "off") << "\n";
+        out << "streaming.start_chunks," << info.startChunks << "\n";
+        out << "streaming.wait_s," << formatValue(info.streamingWaitSeconds) << "\n";
+        for (const auto &[name, value] : metrics)
+            out << name << "," << formatValue(value) << "\n";
+    }
+    else
+    {
+        out << "{\n";
+        out << "  \"path\": \"" << escapeJson(info.pathName) << "\",\n";
+        out << "  \"seed\": " << info.seed << ",\n";
+        out << "  \"width\": " << info.width << ",\n";
+        out << "  \"height\": " << info.height << ",\n";
+        out << "  \"render_distance\": " << formatValue(info.renderDistance) << ",\n";
+        out << "  \"occlusion_culling\": \"" << (info.occlusionCulling ? "on" : "off") << "\",\n";
+        out << "  \"streaming.start_chunks\": " << info.startChunks << ",\n";
+        out << "  \"streaming.wait_s\": " << formatValue(info.streamingWaitSeconds);
+        for (const auto &[name, value] : metrics)
+            out << ",\n  \"" << name << "\": " << formatValue(value);
+        out << "\n}\n";
+    }
+    return static_cast<bool>(out);
+}
+
+std::string BenchmarkReport::getSummary() const
+{
+    Distribution frame = summarize(frameMs);
+    char line[160];
+    std::snprintf(line, sizeof(line), "%zu frames, frame time avg %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f",
+                  frameMs.size(), frame.average, frame.p50, frame.p95, frame.p99, frame.max);
+    return line;
+}
@@ -0,0 +1,65 @@
+#ifndef BENCHMARK_REPORT_H
+#define BENCHMARK_REPORT_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include "frameProfiler.h"
+#include "../Rendering/renderStats.h"
+
+// How a benchmark was run; written at the top of the report so two reports only
+// compare cleanly when these match
+struct BenchmarkInfo
+{
+    std::string pathName;
+    unsigned int seed = 0;
+    unsigned int width = 0, height = 0;
+    float renderDistance = 0.0f;
+    bool occlusionCulling = true; // As the run ended; O can flip it mid-run
+    // The whole radius is streamed in before the path starts and after every step along
+    // it, outside the timed frames, so chunk counts don't depend on worker timing
+    std::size_t startChunks = 0;       // Loaded when the path started
+    double streamingWaitSeconds = 0.0; // Spent waiting for chunks along the path
+};
+
+// Per-frame samples from a benchmark run, summarized into frame-time percentiles,
+// per-stage CPU timings, GPU pass timings, chunk counts and draw counters. The
+// report is one metric per line in a fixed order with no timestamps, so reports
+// from two builds can be compared with a plain diff.
+class BenchmarkReport
+{
+public:
+    // Call right after FrameProfiler::nextFrame, which closes the frame being recorded
+    void addFrame(const FrameProfiler &profiler, std::size_t loadedChunks, std::size_t visibleChunks,
+                  const RenderStats &stats);
+
+    std::size_t getFrameCount() const { return frameMs.size(); }
+
+    // JSON, or CSV when the path ends in ".csv"
+    bool write(const std::string &path, const BenchmarkInfo &info) const;
+    // A few headline numbers for the console
+    std::string getSummary() const;
+
+private:
+    struct Distribution
+    {
+        double average = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+    };
+
+    std::vector<double> frameMs;
+    std::vector<std::string> stageNames;
+    std::vector<std::vector<double>> stageMs; // Per stage, per frame
+    std::array<std::vector<double>, RENDER_PASS_COUNT> gpuMs; // Only frames the pass was timed
+    std::vector<double> loadedChunks;
+    std::vector<double> visibleChunks;
+    std::vector<double> drawCalls;
+    std::vector<double> triangles;
+
+    static Distribution summarize(std::vector<double> values);
+    // Flattened "name", value pairs in report order
+    std::vector<std::pair<std::string, double>> getMetrics() const;
+};
+
+#endif // BENCHMARK_REPORT_H
@@ -0,0 +1,128 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct CameraKeyframe
+{
+    float time = 0.0f; // Seconds from the start of the path
+    glm::vec3 position{0.0f};
+    float yaw = -90.0f; // Degrees, as Camera uses them
+    float pitch = 0.0f;
+};
+
+// Camera keyframes read from a text file, one per line:
+//   time x y z yaw pitch
+// Blank lines and lines starting with '#' are skipped; times must increase.
+// Positions follow a Catmull-Rom spline through the keyframes and angles are
+// interpolated linearly, so a given time always gives the same pose.
+class CameraPath
+{
+public:
+    bool load(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "Failed to open camera path " << path << std::endl;
+            return false;
+        }
+        std::vector<CameraKeyframe> loaded;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            std::size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#')
+                continue;
+            std::istringstream fields(line);
+            CameraKeyframe key;
+            if (!(fields >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch))
+            {
+                std::cerr << path << ":" << lineNumber << ": expected 'time x y z yaw pitch'" << std::endl;
+                return false;
+            }
+            if (!loaded.empty() && key.time <= loaded.back().time)
+            {
+                std::cerr << path << ":" << lineNumber << ": keyframe times must increase" << std::endl;
+                return false;
+            }
+            loaded.push_back(key);
+        }
+        if (loaded.empty())
+        {
+            std::cerr << "Camera path " << path << " has no keyframes" << std::endl;
+            return false;
+        }
+        keyframes = std::move(loaded);
+        return true;
+    }
+
+    bool save(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "# time x y z yaw pitch\n";
+        for (const auto &key : keyframes)
+            out << key.time << " " << key.position.x << " " << key.position.y << " " << key.position.z << " " << key.yaw
+                << " " << key.pitch << "\n";
+        return static_cast<bool>(out);
+    }
+
+    // Keyframes must be added in time order
+    void addKeyframe(const CameraKeyframe &key) { keyframes.push_back(key); }
+
+    bool isEmpty() const { return keyframes.empty(); }
+    std::size_t getKeyframeCount() const { return keyframes.size(); }
+    float getDuration() const { return keyframes.empty() ? 0.0f : keyframes.back().time; }
+
+    // Pose at `time`, held at the ends outside the path
+    CameraKeyframe sample(float time) const
+    {
+        if (keyframes.empty())
+            return {};
+        if (time <= keyframes.front().time)
+            return keyframes.front();
+        if (time >= keyframes.back().time)
+            return keyframes.back();
+
+        auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                     [](float t, const CameraKeyframe &key) { return t < key.time; });
+        std::size_t i = static_cast<std::size_t>(next - keyframes.begin()) - 1;
+        const CameraKeyframe &a = keyframes[i];
+        const CameraKeyframe &b = keyframes[i + 1];
+        // End segments reuse their own endpoint as the missing neighbour
+        const CameraKeyframe &before = i > 0 ? keyframes[i - 1] : a;
+        const CameraKeyframe &after = i + 2 < keyframes.size() ? keyframes[i + 2] : b;
+        float t = (time - a.time) / (b.time - a.time);
+
+        CameraKeyframe result;
+        result.time = time;
+        result.position = catmullRom(before.position, a.position, b.position, after.position, t);
+        result.yaw = a.yaw + (b.yaw - a.yaw) * t;
+        result.pitch = a.pitch + (b.pitch - a.pitch) * t;
+        return result;
+    }
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+
+    static glm::vec3 catmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t)
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                       (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+};
+
+#endif // CAMERA_PATH_H
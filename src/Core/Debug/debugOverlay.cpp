@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "debugOverlay.h"
+
+namespace
+{
+    const glm::vec4 PANEL_COLOR(0.0f, 0.0f, 0.0f, 0.6f);
+    const glm::vec4 TEXT_COLOR(1.0f);
+    const glm::vec4 DIM_COLOR(0.7f, 0.7f, 0.7f, 1.0f);
+    const glm::vec4 TRACK_COLOR(1.0f, 1.0f, 1.0f, 0.25f);
+    const glm::vec4 HANDLE_COLOR(1.0f, 1.0f, 1.0f, 0.9f);
+
+    // Green within a 60 Hz frame, yellow within 30 Hz, red past that
+    glm::vec4 frameColor(float ms)
+    {
+        if (ms <= 1000.0f / 60.0f)
+            return glm::vec4(0.3f, 0.9f, 0.3f, 0.9f);
+        if (ms <= 1000.0f / 30.0f)
+            return glm::vec4(0.95f, 0.8f, 0.2f, 0.9f);
+        return glm::vec4(0.95f, 0.3f, 0.25f, 0.9f);
+    }
+}
+
+DebugOverlay::DebugOverlay(std::shared_ptr<TextRenderer> text, const FrameProfiler &profiler)
+    : text(std::move(text)), profiler(profiler)
+{
+}
+
+int DebugOverlay::addSlider(const std::string &label, float value, float min, float max, float step)
+{
+    Slider slider;
+    slider.label = label;
+    slider.value = std::clamp(value, min, max);
+    slider.min = min;
+    slider.max = max;
+    slider.step = step;
+    sliders.push_back(std::move(slider));
+    hasRefreshed = false;
+    return static_cast<int>(sliders.size()) - 1;
+}
+
+void DebugOverlay::refreshText()
+{
+    char line[128];
+    double frameMs = profiler.getAverageFrameMs();
+    std::snprintf(line, sizeof(line), "Frame: %.2f ms (%.0f FPS)", frameMs, frameMs > 0.0 ? 1000.0 / frameMs : 0.0);
+    frameLine = line;
+
+    const auto &stages = profiler.getStages();
+    stageValues.resize(stages.size());
+    for (std::size_t i = 0; i < stages.size(); i++)
+    {
+        std::snprintf(line, sizeof(line), "%.2f ms", stages[i].averageMs);
+        stageValues[i] = line;
+    }
+
+    std::snprintf(line, sizeof(line), "Chunks: %zu loaded, %zu meshing\n%zu queued, %zu visible\n", stats.loadedChunks,
+                  stats.meshingChunks, stats.queuedChunks, stats.visibleChunks);
+    statsText = line;
+    statsText += "GPU:";
+    for (int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+    {
+        if (renderStats.gpuMs[pass] < 0.0)
+            continue;
+        std::snprintf(line, sizeof(line), " %s %.2f", getRenderPassName(static_cast<RenderPass>(pass)), renderStats.gpuMs[pass]);
+        statsText += line;
+    }
+    const RenderCounters &counters = renderStats.counters;
+    std::snprintf(line, sizeof(line), " ms\nDraws: %llu, triangles: %.2fM\nUploads: %.1f KB, binds: %llu tex, %llu prog",
+                  static_cast<unsigned long long>(counters.drawCalls), counters.triangles / 1.0e6,
+                  counters.bufferBytes / 1024.0, static_cast<unsigned long long>(counters.textureBinds),
+                  static_cast<unsigned long long>(counters.programBinds));
+    statsText += line;
+    statsLines = static_cast<int>(std::count(statsText.begin(), statsText.end(), '\n')) + 1;
+
+    for (auto &slider : sliders)
+    {
+        std::snprintf(line, sizeof(line), "%s: %g", slider.label.c_str(), slider.value);
+        slider.text = line;
+    }
+}
+
+void DebugOverlay::updateSlider(Slider &slider, const glm::vec2 &trackMin, const glm::vec2 &trackSize,
+                                const glm::vec2 &mouse, bool mouseDown)
+{
+    slider.released = false;
+    if (!mouseDown)
+    {
+        slider.released = slider.dragging && slider.moved;
+        slider.dragging = false;
+        slider.moved = false;
+        return;
+    }
+    // Grabbing starts on the track, with some slack above and below it
+    bool overTrack = mouse.x >= trackMin.x && mouse.x <= trackMin.x + trackSize.x &&
+                     std::abs(mouse.y - (trackMin.y + trackSize.y * 0.5f)) <= trackSize.y;
+    if (!slider.dragging && !wasMouseDown && overTrack)
+        slider.dragging = true;
+    if (!slider.dragging)
+        return;
+
+    float t = std::clamp((mouse.x - trackMin.x) / trackSize.x, 0.0f, 1.0f);
+    float value = slider.min + t * (slider.max - slider.min);
+    if (slider.step > 0.0f)
+        value = slider.min + std::round((value - slider.min) / slider.step) * slider.step;
+    value = std::clamp(value, slider.min, slider.max);
+    if (value != slider.value)
+    {
+        slider.value = value;
+        slider.moved = true;
+        hasRefreshed = false; // Show the new value right away
+    }
+}
+
+void DebugOverlay::draw(Renderer2D &renderer, const glm::vec2 &mouse, bool mouseDown)
+{
+    if (!text || !text->hasFont())
+        return;
+
+    auto now = FrameProfiler::Clock::now();
+    if (!hasRefreshed || std::chrono::duration<double>(now - lastRefresh).count() >= TEXT_REFRESH_SECONDS)
+    {
+        refreshText();
+        lastRefresh = now;
+        hasRefreshed = true;
+    }
+
+    const float lineHeight = static_cast<float>(text->getLineHeight());
+    const auto &stages = profiler.getStages();
+    const float innerWidth = PANEL_WIDTH - PADDING * 2.0f;
+    const float panelHeight = PADDING * 2.0f + lineHeight * (1.0f + statsLines + stages.size()) + GRAPH_HEIGHT + PADDING +
+                              sliders.size() * (lineHeight + SLIDER_HEIGHT + PADDING);
+    const glm::vec2 origin(PADDING);
+    renderer.drawQuad(origin, glm::vec2(PANEL_WIDTH, panelHeight), PANEL_COLOR);
+
+    glm::vec2 cursor = origin + glm::vec2(PADDING);
+    text->drawText(renderer, frameLine, cursor, TEXT_COLOR);
+    cursor.y += lineHeight;
+
+    // Frame-time graph, newest on the right, with a line at 60 Hz
+    std::size_t count = profiler.getHistoryCount();
+    float barWidth = innerWidth / FrameProfiler::HISTORY_SIZE;
+    float graphBottom = cursor.y + GRAPH_HEIGHT;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        float ms = profiler.getHistory(i);
+        float height = std::min(ms / GRAPH_MAX_MS, 1.0f) * GRAPH_HEIGHT;
+        float x = cursor.x + innerWidth - (count - i) * barWidth;
+        renderer.drawQuad(glm::vec2(x, graphBottom - height), glm::vec2(barWidth, height), frameColor(ms));
+    }
+    float targetY = graphBottom - (1000.0f / 60.0f) / GRAPH_MAX_MS * GRAPH_HEIGHT;
+    renderer.drawQuad(glm::vec2(cursor.x, targetY), glm::vec2(innerWidth, 1.0f), TRACK_COLOR);
+    cursor.y += GRAPH_HEIGHT + PADDING;
+
+    for (std::size_t i = 0; i < stages.size() && i < stageValues.size(); i++)
+    {
+        text->drawText(renderer, stages[i].name, cursor, DIM_COLOR);
+        float valueWidth = text->measureText(stageValues[i]).x;
+        text->drawText(renderer, stageValues[i], glm::vec2(cursor.x + innerWidth - valueWidth, cursor.y), TEXT_COLOR);
+        cursor.y += lineHeight;
+    }
+
+    text->drawText(renderer, statsText, cursor, TEXT_COLOR);
+    cursor.y += lineHeight * statsLines + PADDING;
+
+    for (auto &slider : sliders)
+    {
+        text->drawText(renderer, slider.text, cursor, TEXT_COLOR);
+        cursor.y += lineHeight;
+        glm::vec2 trackSize(innerWidth, SLIDER_HEIGHT * 0.4f);
+        glm::vec2 trackMin(cursor.x, cursor.y + (SLIDER_HEIGHT - trackSize.y) * 0.5f);
+        updateSlider(slider, trackMin, trackSize, mouse, mouseDown);
+
+        renderer.drawQuad(trackMin, trackSize, TRACK_COLOR);
+        float t = slider.max > slider.min ? (slider.value - slider.min) / (slider.max - slider.min) : 0.0f;
+        renderer.drawQuad(glm::vec2(cursor.x + t * innerWidth - SLIDER_HEIGHT * 0.5f, cursor.y),
+                          glm::vec2(SLIDER_HEIGHT), HANDLE_COLOR);
+        cursor.y += SLIDER_HEIGHT + PADDING;
+    }
+    wasMouseDown = mouseDown;
+}
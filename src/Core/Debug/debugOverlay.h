@@ -0,0 +1,86 @@
+#ifndef DEBUG_OVERLAY_H
+#define DEBUG_OVERLAY_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frameProfiler.h"
+#include "../Rendering/renderStats.h"
+#include "../Renderer/renderer2D.h"
+#include "../Renderer/textRenderer.h"
+
+// Counts shown under the timings; filled in by whoever owns the world
+struct DebugOverlayStats
+{
+    std::size_t loadedChunks = 0;
+    std::size_t meshingChunks = 0;
+    std::size_t queuedChunks = 0;
+    std::size_t visibleChunks = 0;
+};
+
+// Performance panel drawn with Renderer2D and TextRenderer: a frame-time graph, the
+// profiler's stage timings, chunk counts and a few sliders. Numbers are reformatted
+// a few times a second, so most frames only replay cached text layouts; the graph is
+// one quad per frame of history, which the 2D batcher draws in a single call.
+class DebugOverlay
+{
+public:
+    DebugOverlay(std::shared_ptr<TextRenderer> text, const FrameProfiler &profiler);
+
+    // Returns the slider's index; values snap to multiples of `step` from `min`
+    int addSlider(const std::string &label, float value, float min, float max, float step);
+    float getSliderValue(int slider) const { return sliders[slider].value; }
+    // True on the frame the user lets go of a slider they moved
+    bool wasSliderReleased(int slider) const { return sliders[slider].released; }
+
+    void setStats(const DebugOverlayStats &stats) { this->stats = stats; }
+    void setRenderStats(const RenderStats &stats) { renderStats = stats; }
+
+    // `mouseDown` is whether the left button is held with the cursor free; sliders
+    // ignore the mouse otherwise
+    void draw(Renderer2D &renderer, const glm::vec2 &mouse, bool mouseDown);
+
+private:
+    struct Slider
+    {
+        std::string label;
+        float value = 0.0f;
+        float min = 0.0f;
+        float max = 1.0f;
+        float step = 0.0f;
+        bool dragging = false;
+        bool moved = false;
+        bool released = false;
+        std::string text;
+    };
+
+    static constexpr float PANEL_WIDTH = 320.0f;
+    static constexpr float PADDING = 8.0f;
+    static constexpr float GRAPH_HEIGHT = 60.0f;
+    static constexpr float GRAPH_MAX_MS = 50.0f; // Top of the graph
+    static constexpr float SLIDER_HEIGHT = 10.0f;
+    static constexpr double TEXT_REFRESH_SECONDS = 0.25;
+
+    std::shared_ptr<TextRenderer> text;
+    const FrameProfiler &profiler;
+    std::vector<Slider> sliders;
+    DebugOverlayStats stats;
+    RenderStats renderStats;
+
+    // Text as of the last refresh
+    std::string frameLine;
+    std::vector<std::string> stageValues;
+    std::string statsText; // Chunk counts, GPU pass times and draw counters, several lines
+    int statsLines = 0;
+    FrameProfiler::Clock::time_point lastRefresh;
+    bool hasRefreshed = false;
+    bool wasMouseDown = false; // Sliders are only grabbed on the press itself
+
+    void refreshText();
+    void updateSlider(Slider &slider, const glm::vec2 &trackMin, const glm::vec2 &trackSize,
+                      const glm::vec2 &mouse, bool mouseDown);
+};
+
+#endif // DEBUG_OVERLAY_H
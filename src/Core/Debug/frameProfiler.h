@@ -0,0 +1,131 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// CPU time of the named stages of a frame plus a rolling history of whole-frame times.
+// Stages are registered once and timed with scoped timers; while disabled a timer
+// doesn't even read the clock, so the instrumentation can stay in the main loop.
+class FrameProfiler
+{
+public:
+    static const std::size_t HISTORY_SIZE = 240; // Frames kept for the graph
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage
+    {
+        std::string name;
+        double lastMs = 0.0;    // Total of last frame
+        double averageMs = 0.0; // Smoothed over roughly the last second
+    };
+
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler *profiler, int stage) : profiler(profiler), stage(stage)
+        {
+            if (profiler)
+                start = Clock::now();
+        }
+        ~Scope()
+        {
+            if (profiler)
+                profiler->addTime(stage, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        FrameProfiler *profiler;
+        int stage;
+        Clock::time_point start;
+    };
+
+    int addStage(const std::string &name)
+    {
+        stages.push_back({name});
+        running.push_back(0.0);
+        return static_cast<int>(stages.size()) - 1;
+    }
+
+    // Times the enclosing block as part of `stage`; a stage can be entered several times a frame
+    Scope scope(int stage) { return Scope(enabled ? this : nullptr, stage); }
+
+    void setEnabled(bool enable)
+    {
+        if (enable && !enabled)
+            hasFrameStart = false; // Don't count the time spent hidden as one long frame
+        enabled = enable;
+    }
+    bool isEnabled() const { return enabled; }
+
+    // Closes the previous frame and starts the next; call once per frame at the same spot
+    void nextFrame()
+    {
+        if (!enabled)
+            return;
+        Clock::time_point now = Clock::now();
+        lastFrameMs = -1.0;
+        if (hasFrameStart)
+        {
+            double frameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+            lastFrameMs = frameMs;
+            frameTimes[frameCursor] = static_cast<float>(frameMs);
+            frameCursor = (frameCursor + 1) % HISTORY_SIZE;
+            frameCount++;
+            averageFrameMs += (frameMs - averageFrameMs) * SMOOTHING;
+        }
+        for (std::size_t i = 0; i < stages.size(); i++)
+        {
+            stages[i].lastMs = running[i];
+            stages[i].averageMs += (running[i] - stages[i].averageMs) * SMOOTHING;
+            running[i] = 0.0;
+        }
+        frameStart = now;
+        hasFrameStart = true;
+    }
+
+    // Leaves the time since `since` out of the frame in progress, for waits that are
+    // part of setting a frame up rather than of making it
+    void excludeSince(Clock::time_point since)
+    {
+        if (enabled && hasFrameStart)
+            frameStart += Clock::now() - since;
+    }
+
+    const std::vector<Stage> &getStages() const { return stages; }
+    double getAverageFrameMs() const { return averageFrameMs; }
+    // The frame nextFrame just closed, or -1 if it had no start to measure from
+    double getLastFrameMs() const { return lastFrameMs; }
+
+    // Oldest first; fewer than HISTORY_SIZE until that many frames have been timed
+    std::size_t getHistoryCount() const { return frameCount < HISTORY_SIZE ? frameCount : HISTORY_SIZE; }
+    float getHistory(std::size_t i) const
+    {
+        std::size_t oldest = frameCount < HISTORY_SIZE ? 0 : frameCursor;
+        return frameTimes[(oldest + i) % HISTORY_SIZE];
+    }
+
+private:
+    static constexpr double SMOOTHING = 1.0 / 60.0;
+
+    std::vector<Stage> stages;
+    std::vector<double> running; // Time so far this frame, per stage
+    std::array<float, HISTORY_SIZE> frameTimes{};
+    std::size_t frameCursor = 0;
+    std::size_t frameCount = 0;
+    double averageFrameMs = 0.0;
+    double lastFrameMs = -1.0;
+    Clock::time_point frameStart;
+    bool hasFrameStart = false;
+    bool enabled = false;
+
+    void addTime(int stage, double ms) { running[stage] += ms; }
+};
+
+#endif // FRAME_PROFILER_H
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include "metrics.h"
+
+namespace
+{
+    struct Registry
+    {
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+        std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+        std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+        std::map<std::string, std::function<std::uint64_t()>> counterSources;
+        std::map<std::string, std::function<std::int64_t()>> gaugeSources;
+        std::uint64_t startNs = Metrics::now();
+    };
+
+    // Leaked so metrics can still be touched by threads running during static destruction
+    Registry &getRegistry()
+    {
+        static Registry *registry = new Registry();
+        return *registry;
+    }
+
+    template <typename Metric>
+    Metric &findOrAdd(std::map<std::string, std::unique_ptr<Metric>> &metrics, const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(getRegistry().mutex);
+        auto &metric = metrics[name];
+        if (!metric)
+            metric = std::make_unique<Metric>();
+        return *metric;
+    }
+
+    std::string formatValue(double value)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        return text;
+    }
+
+    // Pairs sorted by name, so the previous value of a metric is a binary search away
+    template <typename Value>
+    const Value *findPrevious(const std::vector<std::pair<std::string, Value>> &previous, const std::string &name)
+    {
+        auto it = std::lower_bound(previous.begin(), previous.end(), name,
+                                   [](const auto &entry, const std::string &key) { return entry.first < key; });
+        return it != previous.end() && it->first == name ? &it->second : nullptr;
+    }
+}
+
+int MetricHistogram::getBucket(std::uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+        return static_cast<int>(value);
+    int exponent = static_cast<int>(std::bit_width(value)) - 1; // At least 4
+    int sub = static_cast<int>(value >> (exponent - 4)) - SUB_BUCKETS;
+    return SUB_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+}
+
+std::uint64_t MetricHistogram::getBucketStart(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return static_cast<std::uint64_t>(bucket);
+    int exponent = (bucket - SUB_BUCKETS) / SUB_BUCKETS + 4;
+    std::uint64_t sub = static_cast<std::uint64_t>((bucket - SUB_BUCKETS) % SUB_BUCKETS);
+    return (SUB_BUCKETS + sub) << (exponent - 4);
+}
+
+std::uint64_t MetricHistogram::getBucketWidth(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return 1;
+    return std::uint64_t(1) << ((bucket - SUB_BUCKETS) / SUB_BUCKETS);
+}
+
+void MetricHistogram::record(std::uint64_t value)
+{
+    buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    std::uint64_t seen = max.load(std::memory_order_relaxed);
+    while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const
+{
+    Snapshot result;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    result.count = count.load(std::memory_order_relaxed);
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.max = max.load(std::memory_order_relaxed);
+    return result;
+}
+
+double MetricHistogram::Snapshot::percentile(double p) const
+{
+    std::uint64_t total = 0;
+    for (std::uint64_t bucketCount : buckets)
+        total += bucketCount;
+    if (total == 0)
+        return 0.0;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * total));
+    rank = std::clamp<std::uint64_t>(rank, 1, total);
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return std::min(getBucketStart(i) + (getBucketWidth(i) - 1) / 2.0, static_cast<double>(max));
+    }
+    return static_cast<double>(max);
+}
+
+double MetricHistogram::Snapshot::getMax() const
+{
+    for (int i = BUCKET_COUNT - 1; i >= 0; i--)
+    {
+        if (buckets[i] != 0)
+            return std::min(static_cast<double>(getBucketStart(i) + getBucketWidth(i) - 1), static_cast<double>(max));
+    }
+    return 0.0;
+}
+
+MetricHistogram::Snapshot MetricHistogram::Snapshot::since(const Snapshot &earlier) const
+{
+    Snapshot result;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        result.buckets[i] = buckets[i] - std::min(buckets[i], earlier.buckets[i]);
+    result.count = count - std::min(count, earlier.count);
+    result.sum = sum - std::min(sum, earlier.sum);
+    result.max = max;
+    return result;
+}
+
+MetricCounter &Metrics::counter(const std::string &name) { return findOrAdd(getRegistry().counters, name); }
+
+MetricGauge &Metrics::gauge(const std::string &name) { return findOrAdd(getRegistry().gauges, name); }
+
+MetricHistogram &Metrics::histogram(const std::string &name) { return findOrAdd(getRegistry().histograms, name); }
+
+void Metrics::addCounterSource(const std::string &name, std::function<std::uint64_t()> read)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.counterSources[name] = std::move(read);
+}
+
+void Metrics::addGaugeSource(const std::string &name, std::function<std::int64_t()> read)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.gaugeSources[name] = std::move(read);
+}
+
+Metrics::Snapshot Metrics::snapshot()
+{
+    Registry &registry = getRegistry();
+    Snapshot result;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    result.uptimeSeconds = (now() - registry.startNs) / 1.0e9;
+    for (const auto &[name, metric] : registry.counters)
+        result.counters.push_back({name, metric->get()});
+    for (const auto &[name, read] : registry.counterSources)
+        result.counters.push_back({name, read()});
+    for (const auto &[name, metric] : registry.gauges)
+        result.gauges.push_back({name, metric->get()});
+    for (const auto &[name, read] : registry.gaugeSources)
+        result.gauges.push_back({name, read()});
+    for (const auto &[name, metric] : registry.histograms)
+        result.histograms.push_back({name, metric->snapshot()});
+    auto byName = [](const auto &a, const auto &b) { return a.first < b.first; };
+    std::sort(result.counters.begin(), result.counters.end(), byName);
+    std::sort(result.gauges.begin(), result.gauges.end(), byName);
+    return result;
+}
+
+void MetricsReporter::start(const std::string &path, double intervalSeconds)
+{
+    stop();
+    this->path = path;
+    interval = std::chrono::duration<double>(intervalSeconds);
+    stopRequested = false;
+    worker = std::thread([this]() { run(); });
+}
+
+void MetricsReporter::stop()
+{
+    if (!worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void MetricsReporter::run()
+{
+    Metrics::Snapshot previous = Metrics::snapshot();
+    bool stopping = false;
+    bool reportedFailure = false;
+    while (!stopping)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopping = wake.wait_for(lock, interval, [this]() { return stopRequested; });
+        }
+        Metrics::Snapshot current = Metrics::snapshot();
+        if (!write(path, current, previous) && !reportedFailure)
+        {
+            std::cerr << "Failed to write metrics to " << path << std::endl;
+            reportedFailure = true; // Once; the next dump may well succeed
+        }
+        previous = std::move(current);
+    }
+}
+
+bool MetricsReporter::write(const std::string &path, const Metrics::Snapshot &current, const Metrics::Snapshot &previous)
+{
+    double seconds = current.uptimeSeconds - previous.uptimeSeconds;
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream out(temporaryPath);
+        if (!out)
+            return false;
+        out << "{\n";
+        out << "  \"uptime_s\": " << formatValue(current.uptimeSeconds) << ",\n";
+        out << "  \"interval_s\": " << formatValue(seconds) << ",\n";
+
+        out << "  \"counters\": {";
+        const char *separator = "\n";
+        for (const auto &[name, total] : current.counters)
+        {
+            const std::uint64_t *before = findPrevious(previous.counters, name);
+            std::uint64_t delta = before && *before <= total ? total - *before : 0;
+            out << separator << "    \"" << name << "\": {\"total\": " << total
+                << ", \"per_s\": " << formatValue(seconds > 0.0 ? delta / seconds : 0.0) << "}";
+            separator = ",\n";
+        }
+        out << "\n  },\n";
+
+        out << "  \"gauges\": {";
+        separator = "\n";
+        for (const auto &[name, level] : current.gauges)
+        {
+            out << separator << "    \"" << name << "\": " << level;
+            separator = ",\n";
+        }
+        out << "\n  },\n";
+
+        out << "  \"histograms\": {";
+        separator = "\n";
+        for (const auto &[name, histogram] : current.histograms)
+        {
+            const MetricHistogram::Snapshot *before = findPrevious(previous.histograms, name);
+            MetricHistogram::Snapshot recent = before ? histogram.since(*before) : histogram;
+            out << separator << "    \"" << name << "\": {\"count\": " << recent.count
+                << ", \"total_count\": " << histogram.count
+                << ", \"avg\": " << formatValue(recent.count > 0 ? static_cast<double>(recent.sum) / recent.count : 0.0)
+                << ", \"p50\": " << formatValue(recent.percentile(50.0))
+                << ", \"p90\": " << formatValue(recent.percentile(90.0))
+                << ", \"p99\": " << formatValue(recent.percentile(99.0))
+                << ", \"max\": " << formatValue(recent.getMax()) << "}";
+            separator = ",\n";
+        }
+        out << "\n  }\n}\n";
+        if (!out)
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    return !error;
+}
@@ -0,0 +1,148 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Running total of events, e.g. chunks generated; reports turn it into a rate
+class MetricCounter
+{
+public:
+    void add(std::uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+    std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value{0};
+};
+
+// Current level of something, e.g. a queue depth or resident bytes
+class MetricGauge
+{
+public:
+    void set(std::int64_t level) { value.store(level, std::memory_order_relaxed); }
+    void add(std::int64_t amount) { value.fetch_add(amount, std::memory_order_relaxed); }
+    std::int64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> value{0};
+};
+
+// Distribution of integer samples (microseconds, bytes, ...) in log-linear buckets, as
+// HdrHistogram lays them out: exact below 16, then 16 buckets per power of two. Any
+// value lands within 1/16 of itself with no range chosen up front, and recording is a
+// few relaxed atomic adds.
+class MetricHistogram
+{
+public:
+    static const int SUB_BUCKETS = 16;
+    static const int BUCKET_COUNT = SUB_BUCKETS + (64 - 4) * SUB_BUCKETS;
+
+    struct Snapshot
+    {
+        std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t max = 0; // Over the histogram's whole life
+
+        // Nearest-rank percentile, as the middle of its bucket; 0 without samples
+        double percentile(double p) const;
+        // Upper end of the highest bucket in use, capped at max
+        double getMax() const;
+        // Samples recorded after `earlier` was taken
+        Snapshot since(const Snapshot &earlier) const;
+    };
+
+    void record(std::uint64_t value);
+    // Buckets are read one at a time, so samples landing meanwhile may be half counted
+    Snapshot snapshot() const;
+
+    static int getBucket(std::uint64_t value);
+    static std::uint64_t getBucketStart(int bucket);
+    static std::uint64_t getBucketWidth(int bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> max{0};
+};
+
+// Process-wide named metrics. Looking a name up takes a lock, so call sites keep the
+// reference in a function-local static and only touch atomics after that:
+//     static MetricCounter &generated = Metrics::counter("chunks.generated");
+//     generated.add();
+// Metrics live until the process exits.
+class Metrics
+{
+public:
+    struct Snapshot
+    {
+        double uptimeSeconds = 0.0;
+        std::vector<std::pair<std::string, std::uint64_t>> counters;
+        std::vector<std::pair<std::string, std::int64_t>> gauges;
+        std::vector<std::pair<std::string, MetricHistogram::Snapshot>> histograms;
+    };
+
+    static MetricCounter &counter(const std::string &name);
+    static MetricGauge &gauge(const std::string &name);
+    static MetricHistogram &histogram(const std::string &name);
+
+    // Values read from elsewhere whenever a snapshot is taken, on the thread taking it.
+    // `read` must be thread safe and must not look up metrics itself (the registry is locked).
+    static void addCounterSource(const std::string &name, std::function<std::uint64_t()> read);
+    static void addGaugeSource(const std::string &name, std::function<std::int64_t()> read);
+
+    // Nanoseconds on the steady clock, for latencies that start and end in different places
+    static std::uint64_t now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Every metric, sorted by name
+    static Snapshot snapshot();
+};
+
+// Rewrites a JSON file with every metric at a fixed interval, from a thread of its own,
+// so a sidecar can scrape it without the frame loop ever waiting on the disk. Each dump
+// is written beside the file and renamed over it, so readers never see half of one; a
+// path under /dev/shm keeps the whole exchange in shared memory. Counters are reported
+// with their rate since the previous dump and histograms cover that interval only.
+class MetricsReporter
+{
+public:
+    MetricsReporter() = default;
+    MetricsReporter(const MetricsReporter &) = delete;
+    MetricsReporter &operator=(const MetricsReporter &) = delete;
+    ~MetricsReporter() { stop(); }
+
+    void start(const std::string &path, double intervalSeconds);
+    // Writes a last dump before returning
+    void stop();
+    bool isRunning() const { return worker.joinable(); }
+
+    // One dump of `current`, with rates and histograms relative to `previous`
+    static bool write(const std::string &path, const Metrics::Snapshot &current, const Metrics::Snapshot &previous);
+
+private:
+    std::string path;
+    std::chrono::duration<double> interval{1.0};
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopRequested = false;
+
+    void run();
+};
+
+#endif // METRICS_H
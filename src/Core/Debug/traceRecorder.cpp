@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "traceRecorder.h"
+
+std::atomic<bool> TraceRecorder::enabled{false};
+
+namespace
+{
+    // Fields are relaxed atomics so a dump can read a slot the owner is rewriting;
+    // the counters below tell it afterwards whether that happened
+    struct TraceEvent
+    {
+        std::atomic<const char *> name{nullptr};
+        std::atomic<const char *> category{nullptr};
+        std::atomic<std::uint64_t> start{0};
+        std::atomic<std::uint64_t> end{0};
+    };
+
+    struct ThreadBuffer
+    {
+        std::array<TraceEvent, TraceRecorder::EVENTS_PER_THREAD> events;
+        // Event i goes in slot i % EVENTS_PER_THREAD. `begun` moves before a slot is
+        // written and `written` after, so slots below begun - EVENTS_PER_THREAD are
+        // the only ones known not to have changed under a reader.
+        std::atomic<std::uint64_t> begun{0};
+        std::atomic<std::uint64_t> written{0};
+        // Guarded by the registry mutex
+        std::string name;
+        bool retired = false;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Never freed, tid = index + 1
+    };
+
+    // Leaked so threads still running during static destruction can record safely
+    Registry &getRegistry()
+    {
+        static Registry *registry = new Registry();
+        return *registry;
+    }
+
+    ThreadBuffer *registerThread()
+    {
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (registry.buffers.size() < TraceRecorder::MAX_THREADS)
+        {
+            registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+            registry.buffers.back()->name = "Thread " + std::to_string(registry.buffers.size());
+            return registry.buffers.back().get();
+        }
+        // Out of rings: take over the one of a thread that has exited, and its history with it
+        for (auto &buffer : registry.buffers)
+        {
+            if (!buffer->retired)
+                continue;
+            buffer->retired = false;
+            buffer->begun.store(0);
+            buffer->written.store(0);
+            buffer->name = "Thread " + std::to_string(&buffer - registry.buffers.data() + 1);
+            return buffer.get();
+        }
+        return nullptr;
+    }
+
+    // Plain pointer so the hot path skips the guard a thread_local with a destructor needs
+    thread_local ThreadBuffer *currentBuffer = nullptr;
+    thread_local bool registered = false;
+
+    // Marks the thread's ring as reusable when the thread exits; its spans stay dumpable until then
+    struct ThreadRetirer
+    {
+        ThreadBuffer *buffer = nullptr;
+        ~ThreadRetirer()
+        {
+            currentBuffer = nullptr; // Later thread_local destructors don't record
+            if (!buffer)
+                return;
+            std::lock_guard<std::mutex> lock(getRegistry().mutex);
+            buffer->retired = true;
+        }
+    };
+
+    ThreadBuffer *getThreadBuffer()
+    {
+        if (!registered)
+        {
+            registered = true;
+            currentBuffer = registerThread();
+            static thread_local ThreadRetirer retirer;
+            retirer.buffer = currentBuffer;
+        }
+        return currentBuffer;
+    }
+
+    struct CopiedEvent
+    {
+        const char *name;
+        const char *category;
+        std::uint64_t start, end;
+    };
+
+    void writeJsonString(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (const char *c = text ? text : ""; *c; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+
+    // Chrome trace timestamps are microseconds
+    void writeMicroseconds(std::ostream &out, std::uint64_t ns)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", ns / 1000.0);
+        out << text;
+    }
+}
+
+void TraceRecorder::record(const char *name, const char *category, std::uint64_t startNs, std::uint64_t endNs)
+{
+    if (!isEnabled())
+        return;
+    ThreadBuffer *buffer = getThreadBuffer();
+    if (!buffer)
+        return;
+    std::uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    buffer->begun.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceEvent &event = buffer->events[index & (EVENTS_PER_THREAD - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.start.store(startNs, std::memory_order_relaxed);
+    event.end.store(endNs, std::memory_order_relaxed);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const std::string &name)
+{
+    ThreadBuffer *buffer = getThreadBuffer();
+    if (!buffer)
+        return;
+    std::lock_guard<std::mutex> lock(getRegistry().mutex);
+    buffer->name = name;
+}
+
+bool TraceRecorder::write(const std::string &path, double seconds)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::uint64_t until = now();
+    std::uint64_t since = until - std::min<std::uint64_t>(until, static_cast<std::uint64_t>(seconds * 1.0e9));
+    std::vector<std::string> names;
+    std::vector<std::vector<CopiedEvent>> threads;
+    {
+        // Held only to keep rings from being handed to new threads mid-copy; owners keep recording
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &buffer : registry.buffers)
+        {
+            names.push_back(buffer->name);
+            threads.emplace_back();
+            std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+            std::uint64_t first = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+            std::vector<CopiedEvent> copied;
+            copied.reserve(static_cast<std::size_t>(written - first));
+            for (std::uint64_t i = first; i < written; i++)
+            {
+                const TraceEvent &event = buffer->events[i & (EVENTS_PER_THREAD - 1)];
+                copied.push_back({event.name.load(std::memory_order_relaxed), event.category.load(std::memory_order_relaxed),
+                                  event.start.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed)});
+            }
+            // Anything the owner has started overwriting since is dropped
+            std::atomic_thread_fence(std::memory_order_acquire);
+            std::uint64_t begun = buffer->begun.load(std::memory_order_relaxed);
+            std::uint64_t valid = begun > EVENTS_PER_THREAD ? begun - EVENTS_PER_THREAD : 0;
+            for (std::uint64_t i = std::max(first, valid); i < written; i++)
+            {
+                const CopiedEvent &event = copied[static_cast<std::size_t>(i - first)];
+                if (event.end >= since && event.end <= until)
+                    threads.back().push_back(event);
+            }
+        }
+    }
+
+    // Timestamps start at the beginning of the window so the viewer opens on it
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    for (std::size_t tid = 0; tid < threads.size(); tid++)
+    {
+        out << (firstEvent ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid + 1
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, names[tid].c_str());
+        out << "}}";
+        firstEvent = false;
+        for (const auto &event : threads[tid])
+        {
+            std::uint64_t start = std::max(event.start, since);
+            out << ",\n{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid + 1 << ",\"ts\":";
+            writeMicroseconds(out, start - since);
+            out << ",\"dur\":";
+            writeMicroseconds(out, event.end - start);
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,74 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Timeline of named CPU spans on every thread, written out as Chrome trace event JSON
+// for chrome://tracing or ui.perfetto.dev. Each thread records into a ring of its own
+// without locks or allocation, so recording can stay on all the time; a dump copies
+// whichever spans of the last few seconds are still in the rings. Only the name and
+// category pointers are stored, so they must be string literals.
+class TraceRecorder
+{
+public:
+    static const std::size_t EVENTS_PER_THREAD = 1 << 15; // Power of two
+    static const std::size_t MAX_THREADS = 64;            // Threads past this go unrecorded
+
+    // Nanoseconds on the steady clock, the timebase of record()
+    static std::uint64_t now()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Records a finished span on the calling thread
+    static void record(const char *name, const char *category, std::uint64_t startNs, std::uint64_t endNs);
+
+    // Shown as the calling thread's row in the viewer; unnamed threads are "Thread N"
+    static void setThreadName(const std::string &name);
+
+    // Off by default; spans recorded while off are dropped
+    static void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Spans that ended within the last `seconds`, from every thread. Safe to call while
+    // other threads keep recording; spans they overwrite meanwhile are left out.
+    static bool write(const std::string &path, double seconds);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the enclosing block as one span
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category) : name(name), category(category)
+    {
+        if (TraceRecorder::isEnabled())
+            start = TraceRecorder::now();
+    }
+    ~TraceScope()
+    {
+        if (start != 0)
+            TraceRecorder::record(name, category, start, TraceRecorder::now());
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    std::uint64_t start = 0;
+};
+
+#define VOXELC_TRACE_CONCAT_(a, b) a##b
+#define VOXELC_TRACE_CONCAT(a, b) VOXELC_TRACE_CONCAT_(a, b)
+// VOXELC_TRACE_SCOPE("generateChunk", "world") traces the rest of the enclosing block
+#define VOXELC_TRACE_SCOPE(name, category) TraceScope VOXELC_TRACE_CONCAT(traceScope, __LINE__)(name, category)
+
+#endif // TRACE_RECORDER_H
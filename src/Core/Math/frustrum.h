@@ -2,7 +2,39 @@
 #define FRUSTUM_H
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
 #include <array>
+#include <vector>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_USE_SSE 1
+#endif
+
+// Axis-aligned boxes stored as structure-of-arrays so the frustum can test
+// several of them per instruction.
+struct FrustumBoxList {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void clear() {
+        minX.clear(); minY.clear(); minZ.clear();
+        maxX.clear(); maxY.clear(); maxZ.clear();
+    }
+
+    void reserve(size_t count) {
+        minX.reserve(count); minY.reserve(count); minZ.reserve(count);
+        maxX.reserve(count); maxY.reserve(count); maxZ.reserve(count);
+    }
+
+    void add(const glm::vec3& min, const glm::vec3& max) {
+        minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+        maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+    }
+
+    size_t size() const { return minX.size(); }
+};
 
 class Frustum {
 public:
@@ -23,32 +55,92 @@ public:
         return true;
     }
 
+    // A box is outside when its corner furthest along a plane's normal is behind that plane
+    bool isBoxInFrustum(const glm::vec3& min, const glm::vec3& max) const {
+        for (const auto& plane : planes) {
+            glm::vec3 positive(plane.x > 0.0f ? max.x : min.x,
+                               plane.y > 0.0f ? max.y : min.y,
+                               plane.z > 0.0f ? max.z : min.z);
+            if (distanceToPoint(plane, positive) < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Appends the index of every box that is at least partly inside the frustum.
+    // Conservative: boxes crossing a frustum corner may pass.
+    void cullBoxes(const FrustumBoxList& boxes, std::vector<uint32_t>& visible) const {
+        const size_t count = boxes.size();
+        // Per plane, pick which bound array holds the positive corner once, up front
+        const float* px[6]; const float* py[6]; const float* pz[6];
+        for (int p = 0; p < 6; p++) {
+            px[p] = planes[p].x > 0.0f ? boxes.maxX.data() : boxes.minX.data();
+            py[p] = planes[p].y > 0.0f ? boxes.maxY.data() : boxes.minY.data();
+            pz[p] = planes[p].z > 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+        }
+
+        size_t i = 0;
+#ifdef FRUSTUM_USE_SSE
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 inside = _mm_cmpeq_ps(zero, zero); // All lanes set
+            for (int p = 0; p < 6; p++) {
+                __m128 d = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(px[p] + i), _mm_set1_ps(planes[p].x)),
+                               _mm_mul_ps(_mm_loadu_ps(py[p] + i), _mm_set1_ps(planes[p].y))),
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pz[p] + i), _mm_set1_ps(planes[p].z)),
+                               _mm_set1_ps(planes[p].w)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+            }
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    visible.push_back(static_cast<uint32_t>(i + lane));
+                }
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++) {
+                float d = px[p][i] * planes[p].x + py[p][i] * planes[p].y + pz[p][i] * planes[p].z + planes[p].w;
+                inside = d >= 0.0f;
+            }
+            if (inside) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
 private:
     std::array<glm::vec4, 6> planes; // Left, Right, Bottom, Top, Near, Far
 
+    // Gribb/Hartmann extraction; glm is column-major so the planes come from rows
     glm::vec4 extractPlane(const glm::mat4& m, int side) {
         glm::vec4 plane;
         switch(side) {
             case 0: // Left
-                plane = m[3] + m[0];
+                plane = glm::row(m, 3) + glm::row(m, 0);
                 break;
             case 1: // Right
-                plane = m[3] - m[0];
+                plane = glm::row(m, 3) - glm::row(m, 0);
                 break;
             case 2: // Bottom
-                plane = m[3] + m[1];
+                plane = glm::row(m, 3) + glm::row(m, 1);
                 break;
             case 3: // Top
-                plane = m[3] - m[1];
+                plane = glm::row(m, 3) - glm::row(m, 1);
                 break;
             case 4: // Near
-                plane = m[3] + m[2];
+                plane = glm::row(m, 3) + glm::row(m, 2);
                 break;
             case 5: // Far
-                plane = m[3] - m[2];
+                plane = glm::row(m, 3) - glm::row(m, 2);
                 break;
         }
-        return glm::normalize(plane);
+        // Scale by the normal's length only, so w stays a true distance
+        return plane / glm::length(glm::vec3(plane));
     }
 
     float distanceToPoint(const glm::vec4& plane, const glm::vec3& point) const {
@@ -0,0 +1,113 @@
+#include <cstring>
+#include <stdexcept>
+#include "chunkRenderer.h"
+#include "../assets.h"
+#include "../Debug/metrics.h"
+#include "../Debug/allocationTracker.h"
+
+ChunkRenderer::ChunkGpuState &ChunkRenderer::getState(Chunk &chunk)
+{
+    // Only this class attaches state to chunks
+    if (auto *state = static_cast<ChunkGpuState *>(chunk.getRenderState()))
+        return *state;
+    auto state = std::make_shared<ChunkGpuState>();
+    chunk.setRenderState(state);
+    return *state;
+}
+
+void ChunkRenderer::onMeshBuilt(Chunk &chunk)
+{
+    auto mesh = chunk.getMesh();
+    if (!uploadRing || !mesh)
+        return;
+    VOXELC_TRACE_SCOPE("stageMesh", "upload");
+    getState(chunk).stagedMesh = stageMesh(*mesh);
+}
+
+// Vertices, then indices at the next aligned offset; the layout TerrainRenderer::upload expects.
+// Null when the ring is full, and the upload goes through glBufferSubData instead.
+std::shared_ptr<StagedUpload> ChunkRenderer::stageMesh(const UV_Mesh &mesh) const
+{
+    std::size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+    std::size_t indexBytes = mesh.indices.size() * sizeof(unsigned int);
+    std::size_t indexOffset = (vertexBytes + UploadRing::ALIGNMENT - 1) / UploadRing::ALIGNMENT * UploadRing::ALIGNMENT;
+    if (vertexBytes == 0 || indexBytes == 0)
+        return nullptr;
+    auto staged = uploadRing->reserve(indexOffset + indexBytes);
+    if (!staged)
+        return nullptr;
+    std::memcpy(staged->getData(), mesh.vertices.data(), vertexBytes);
+    std::memcpy(staged->getData() + indexOffset, mesh.indices.data(), indexBytes);
+    staged->finishWriting();
+    return staged;
+}
+
+// Hands the built mesh to the GPU: into the shared terrain arena when the renderer
+// has one, otherwise into the chunk's own vertex buffer
+void ChunkRenderer::upload(Chunk &chunk, ChunkGpuState &state, const std::shared_ptr<Renderer> &renderer)
+{
+    VOXELC_TRACE_SCOPE("uploadMesh", "upload");
+    AllocationScope allocations(ALLOC_RENDER);
+    static MetricCounter &uploaded = Metrics::counter("chunks.uploaded");
+    static MetricCounter &uploadedBytes = Metrics::counter("upload.bytes");
+    auto mesh = chunk.getMesh();
+    uploaded.add();
+    uploadedBytes.add(mesh->vertices.size() * sizeof(Vertex) + mesh->indices.size() * sizeof(unsigned int));
+    if (auto terrain = renderer->getTerrainRenderer())
+    {
+        state.terrainMesh = terrain->upload(mesh->vertices, mesh->indices, state.stagedMesh);
+    }
+    else
+    {
+        if (!state.meshRenderer)
+        {
+            auto &assets = AssetManager::getInstance();
+            auto texture = assets.getTexture("terrain");
+            auto shader = assets.getShader("default");
+            if (!texture || !shader)
+            {
+                throw std::runtime_error("Required assets not found");
+            }
+            state.meshRenderer = std::make_shared<UV_MeshRenderer>(chunk.getTransform());
+            state.meshRenderer->Initialize(chunk.getTransform(), nullptr, shader, texture);
+        }
+        state.meshRenderer->setMesh(mesh);
+    }
+    state.stagedMesh.reset();
+    // A coarse chunk can't be rebuilt, so the arena holds the only copy it needs
+    chunk.setMeshUploaded(chunk.getLod() > 0 && state.terrainMesh);
+}
+
+void ChunkRenderer::queue(Chunk &chunk, const std::shared_ptr<Renderer> &renderer)
+{
+    if (!chunk.isReady())
+        return;
+
+    ChunkGpuState &state = getState(chunk);
+    // Edits are remeshed right here; there's no ring copy to wait for then
+    if (chunk.getMeshState() == ChunkMeshState::OUTDATED)
+        chunk.updateMesh();
+    if (chunk.getMeshState() == ChunkMeshState::QUEUED && chunk.getMesh())
+        upload(chunk, state, renderer);
+    if (chunk.getMeshState() != ChunkMeshState::READY)
+        return;
+
+    unsigned int first, count;
+    chunk.getVisibleIndexRange(first, count);
+    if (count == 0)
+        return;
+    auto terrain = renderer->getTerrainRenderer();
+    if (terrain && state.terrainMesh)
+        terrain->submit(*state.terrainMesh, chunk.getPosition(), first, count);
+    else if (!terrain && state.meshRenderer)
+        state.meshRenderer->queueToRender(renderer, first, count);
+    else
+        return;
+
+    // The edit's new mesh is in this frame's draws
+    if (std::uint64_t editTime = chunk.takeEditTime())
+    {
+        static MetricHistogram &editToVisible = Metrics::histogram("chunks.edit_to_visible_us");
+        editToVisible.record((Metrics::now() - editTime) / 1000);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef CHUNK_RENDERER_H
+#define CHUNK_RENDERER_H
+
+#include <memory>
+#include "../World/chunk.h"
+#include "../Rendering/meshRenderer.h"
+#include "renderer.h"
+#include "terrainRenderer.h"
+#include "uploadRing.h"
+
+// GPU side of the world's chunks, kept out of Chunk so world code runs without a
+// GL context. Each chunk it draws gets its buffers attached as a ChunkRenderState.
+// As the world's mesh listener it also copies fresh meshes into the upload ring on
+// the worker that built them, so the render thread only has to issue a GPU copy.
+class ChunkRenderer : public ChunkMeshListener
+{
+public:
+    // `ring` may be null when the context can't map buffers persistently
+    explicit ChunkRenderer(std::shared_ptr<UploadRing> ring = nullptr) : uploadRing(ring) {}
+
+    // Worker threads, before the chunk is handed to the world
+    void onMeshBuilt(Chunk &chunk) override;
+
+    // Render thread: rebuilds an edited mesh, uploads a new one, then submits the
+    // chunk's visible sections to the terrain renderer or its own mesh renderer
+    void queue(Chunk &chunk, const std::shared_ptr<Renderer> &renderer);
+
+private:
+    struct ChunkGpuState : ChunkRenderState
+    {
+        std::shared_ptr<TerrainMesh> terrainMesh;      // Set on the multi-draw path
+        std::shared_ptr<UV_MeshRenderer> meshRenderer; // Otherwise the chunk has its own buffers
+        std::shared_ptr<StagedUpload> stagedMesh;      // The latest mesh, waiting in the upload ring
+    };
+
+    std::shared_ptr<UploadRing> uploadRing;
+
+    static ChunkGpuState &getState(Chunk &chunk);
+    std::shared_ptr<StagedUpload> stageMesh(const UV_Mesh &mesh) const;
+    void upload(Chunk &chunk, ChunkGpuState &state, const std::shared_ptr<Renderer> &renderer);
+};
+
+#endif // CHUNK_RENDERER_H
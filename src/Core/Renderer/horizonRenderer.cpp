@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "horizonRenderer.h"
+#include "../Block/blockDatabase.h"
+#include "../Rendering/glState.h"
+
+namespace
+{
+    // Average color of a face's atlas tile, weighted by alpha so cut-out texels don't darken it
+    glm::vec3 averageTileColor(const Texture &atlas, const UV_Mesh &mesh, int face)
+    {
+        const auto &pixels = atlas.getBuffer();
+        int width = atlas.getWidth(), height = atlas.getHeight(), channels = atlas.getChannels();
+        if (pixels.empty() || channels < 3)
+            return glm::vec3(0.5f);
+
+        glm::vec2 uvMin(1.0f), uvMax(0.0f);
+        for (int i = 0; i < 4; i++)
+        {
+            const Vertex &v = mesh.vertices[face * 4 + i];
+            uvMin = glm::min(uvMin, glm::vec2(v.u, v.v));
+            uvMax = glm::max(uvMax, glm::vec2(v.u, v.v));
+        }
+        int x0 = std::clamp(static_cast<int>(uvMin.x * width), 0, width - 1);
+        int y0 = std::clamp(static_cast<int>(uvMin.y * height), 0, height - 1);
+        int x1 = std::clamp(static_cast<int>(std::ceil(uvMax.x * width)), x0 + 1, width);
+        int y1 = std::clamp(static_cast<int>(std::ceil(uvMax.y * height)), y0 + 1, height);
+
+        glm::vec3 sum(0.0f);
+        float weight = 0.0f;
+        for (int y = y0; y < y1; y++)
+        {
+            for (int x = x0; x < x1; x++)
+            {
+                const unsigned char *texel = &pixels[(y * width + x) * channels];
+                float alpha = channels == 4 ? texel[3] / 255.0f : 1.0f;
+                sum += glm::vec3(texel[0], texel[1], texel[2]) / 255.0f * alpha;
+                weight += alpha;
+            }
+        }
+        return weight > 0.0f ? sum / weight : glm::vec3(0.5f);
+    }
+}
+
+HorizonRenderer::HorizonRenderer()
+{
+    // Every level is the same grid, so one index buffer serves them all through a base vertex
+    std::vector<unsigned int> indices;
+    indices.reserve(GRID_CELLS * GRID_CELLS * 6);
+    for (int z = 0; z < GRID_CELLS; z++)
+    {
+        for (int x = 0; x < GRID_CELLS; x++)
+        {
+            unsigned int corner = z * GRID_VERTICES + x;
+            indices.push_back(corner);
+            indices.push_back(corner + GRID_VERTICES);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + GRID_VERTICES);
+            indices.push_back(corner + GRID_VERTICES + 1);
+        }
+    }
+    indexCount = static_cast<GLsizei>(indices.size());
+
+    vao = GLState::createVertexArray();
+    vertexBuffer = GLState::createBuffer();
+    GLState::bufferData(vertexBuffer, LEVEL_COUNT * VERTICES_PER_LEVEL * sizeof(HorizonVertex), nullptr, GL_DYNAMIC_DRAW);
+    indexBuffer = GLState::createBuffer();
+    GLState::bufferData(indexBuffer, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    auto &gl = GLState::getInstance();
+    gl.vertexAttrib(vao, 0, vertexBuffer, 3, GL_FLOAT, sizeof(HorizonVertex), offsetof(HorizonVertex, position));
+    gl.vertexAttrib(vao, 1, vertexBuffer, 3, GL_FLOAT, sizeof(HorizonVertex), offsetof(HorizonVertex, color));
+    gl.elementBuffer(vao, indexBuffer);
+    gl.bindVertexArray(0);
+}
+
+HorizonRenderer::~HorizonRenderer()
+{
+    waitForPending();
+    GLState::getInstance().forgetVertexArray(vao);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+}
+
+void HorizonRenderer::setMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> atlas)
+{
+    this->shader = shader;
+    this->atlas = atlas;
+    if (!atlas)
+        return;
+
+    topColors.assign(BLOCK_TYPE_AIR, glm::vec3(0.5f));
+    sideColors.assign(BLOCK_TYPE_AIR, glm::vec3(0.5f));
+    for (int type = 0; type < BLOCK_TYPE_AIR; type++)
+    {
+        try
+        {
+            const auto &mesh = BlockDatabase::getBlockInfo(static_cast<BlockType>(type)).mesh;
+            if (!mesh || mesh->vertices.size() < BLOCK_FACE_COUNT * 4)
+                continue;
+            topColors[type] = averageTileColor(*atlas, *mesh, BLOCK_FACE_TOP);
+            sideColors[type] = averageTileColor(*atlas, *mesh, BLOCK_FACE_FRONT);
+        }
+        catch (const std::runtime_error &)
+        {
+            // Not registered; leave it gray rather than refuse to draw
+        }
+    }
+    // Levels built with the old colors are rebuilt on the next update
+    waitForPending();
+    for (auto &level : levels)
+        level.hasData = false;
+}
+
+void HorizonRenderer::setSampler(HorizonSampler sampler)
+{
+    waitForPending();
+    this->sampler = std::move(sampler);
+    for (auto &level : levels)
+        level.hasData = false;
+}
+
+void HorizonRenderer::waitForPending()
+{
+    for (auto &level : levels)
+    {
+        if (level.pending.valid())
+            level.pending.get();
+    }
+}
+
+glm::ivec2 HorizonRenderer::snapCenter(const glm::vec3 &position, int level)
+{
+    // Snapping to every other cell keeps grid points fixed in the world while the camera moves
+    int step = getSpacing(level) * 2;
+    return glm::ivec2(static_cast<int>(std::floor(position.x / step)) * step,
+                      static_cast<int>(std::floor(position.z / step)) * step);
+}
+
+void HorizonRenderer::update(const glm::vec3 &cameraPosition)
+{
+    for (int i = 0; i < LEVEL_COUNT; i++)
+    {
+        Level &level = levels[i];
+        if (level.pending.valid() && level.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            auto vertices = level.pending.get();
+            GLState::bufferSubData(vertexBuffer, i * VERTICES_PER_LEVEL * sizeof(HorizonVertex),
+                                   vertices.size() * sizeof(HorizonVertex), vertices.data());
+            level.center = level.pendingCenter;
+            level.hasData = true;
+        }
+
+        // One rebuild per level at a time; the old grid stays up until the new one is in
+        glm::ivec2 center = snapCenter(cameraPosition, i);
+        if (!sampler || level.pending.valid() || (level.hasData && center == level.center))
+            continue;
+        level.pendingCenter = center;
+        level.pending = std::async(std::launch::async, &HorizonRenderer::buildLevel, sampler, topColors, sideColors, center, i);
+    }
+}
+
+std::vector<HorizonRenderer::HorizonVertex> HorizonRenderer::buildLevel(HorizonSampler sampler, ColorTable topColors,
+                                                                        ColorTable sideColors, glm::ivec2 center, int level)
+{
+    const int spacing = getSpacing(level);
+    const glm::ivec2 origin = center - glm::ivec2(GRID_CELLS / 2 * spacing);
+
+    // One extra sample on every side for the slopes along the edges
+    const int side = GRID_VERTICES + 2;
+    std::vector<HorizonSample> samples(side * side);
+    for (int z = 0; z < side; z++)
+    {
+        for (int x = 0; x < side; x++)
+            samples[z * side + x] = sampler(origin.x + (x - 1) * spacing, origin.y + (z - 1) * spacing);
+    }
+
+    std::vector<HorizonVertex> vertices(VERTICES_PER_LEVEL);
+    for (int z = 0; z < GRID_VERTICES; z++)
+    {
+        for (int x = 0; x < GRID_VERTICES; x++)
+        {
+            const HorizonSample &sample = samples[(z + 1) * side + x + 1];
+            float dx = samples[(z + 1) * side + x + 2].height - samples[(z + 1) * side + x].height;
+            float dz = samples[(z + 2) * side + x + 1].height - samples[z * side + x + 1].height;
+            // Blocks of rise per block of run; on a staircase that steep, this share of
+            // what you see is block sides rather than tops
+            float slope = std::sqrt(dx * dx + dz * dz) / (2.0f * spacing);
+            float sides = slope / (1.0f + slope);
+
+            HorizonVertex &vertex = vertices[z * GRID_VERTICES + x];
+            // Top face of the surface block
+            vertex.position = glm::vec3(origin.x + x * spacing, sample.height + 0.5f, origin.y + z * spacing);
+            if (sample.block >= 0 && sample.block < static_cast<int>(topColors.size()))
+                vertex.color = glm::mix(topColors[sample.block], sideColors[sample.block], sides);
+            else
+                vertex.color = glm::vec3(0.5f);
+        }
+    }
+    return vertices;
+}
+
+void HorizonRenderer::draw(const glm::mat4 &projection)
+{
+    if (!hasMaterial())
+        return;
+
+    // Same field of view and aspect with the depth range moved out to the horizon
+    float nearPlane = std::max(1.0f, innerRadius * 0.25f);
+    float farPlane = getOuterRadius() * 1.5f;
+    glm::mat4 farProjection = projection;
+    farProjection[2][2] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+    farProjection[3][2] = -2.0f * farPlane * nearPlane / (farPlane - nearPlane);
+
+    shader->use();
+    shader->setMat4("farProjection", farProjection);
+    auto &gl = GLState::getInstance();
+    gl.bindVertexArray(vao);
+    for (int i = 0; i < LEVEL_COUNT; i++)
+    {
+        // Each level draws its own band; the inner edge overlaps the finer level by a cell
+        float ringStart = i == 0 ? innerRadius : std::max(innerRadius, getCoverage(i - 1) - getSpacing(i - 1));
+        float ringEnd = getCoverage(i);
+        if (!levels[i].hasData || ringStart >= ringEnd)
+            continue;
+        shader->setVec2("ringRange", ringStart, ringEnd);
+        glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, i * VERTICES_PER_LEVEL);
+        gl.countDraw(indexCount);
+    }
+    gl.bindVertexArray(0);
+}
@@ -0,0 +1,109 @@
+#ifndef HORIZON_RENDERER_H
+#define HORIZON_RENDERER_H
+
+#include <glad/glad.h>
+#include <array>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../Rendering/shader.h"
+#include "../Rendering/texture.h"
+
+// Terrain surface of one world column: y of the top block and its BlockType
+struct HorizonSample
+{
+    float height;
+    int block;
+};
+
+// Called from background threads, so it must be thread safe
+using HorizonSampler = std::function<HorizonSample(int worldX, int worldZ)>;
+
+// Far terrain past the chunk render distance, drawn as a heightmap clipmap: a few
+// square grids of the same resolution, each twice as coarse and twice as wide as
+// the one before, centered on the camera. Heights come straight from the sampler,
+// no chunks involved. Each level only keeps its own ring of distances. Colors are
+// the average of the surface block's atlas tiles, so from afar the horizon matches
+// what the chunks' textures blur into.
+//
+// The grids are drawn first with a projection of their own, then the depth buffer
+// is cleared for the chunks, so real terrain always covers the horizon where both
+// exist and the two never fight over depth precision.
+class HorizonRenderer
+{
+public:
+    static const int LEVEL_COUNT = 3;
+    static const int GRID_CELLS = 128; // Cells per level side
+    static const int BASE_SPACING = 32; // Blocks per cell on the finest level
+
+    HorizonRenderer();
+    ~HorizonRenderer();
+
+    void setMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> atlas);
+    bool hasMaterial() const { return shader && atlas; }
+
+    // Waits for grids in progress before letting go of the old sampler; pass null
+    // before destroying whatever the sampler reads from
+    void setSampler(HorizonSampler sampler);
+
+    // Distance where the horizon takes over from chunks. Chunks drawn over it win, so
+    // starting inside the chunk radius only fills gaps that haven't streamed in yet.
+    void setInnerRadius(float radius) { innerRadius = radius; }
+    // Horizontal distance the outermost level reaches
+    static float getOuterRadius() { return getCoverage(LEVEL_COUNT - 1); }
+
+    // Starts rebuilding levels the camera has moved away from and uploads finished ones
+    void update(const glm::vec3 &cameraPosition);
+    // View, fog and camera position come from the Camera uniform block; `projection`
+    // only lends its field of view and aspect ratio
+    void draw(const glm::mat4 &projection);
+
+private:
+    struct HorizonVertex
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+    };
+
+    struct Level
+    {
+        glm::ivec2 center{0};
+        bool hasData = false;
+        glm::ivec2 pendingCenter{0};
+        std::future<std::vector<HorizonVertex>> pending;
+    };
+
+    using ColorTable = std::vector<glm::vec3>; // Indexed by BlockType
+
+    static const int GRID_VERTICES = GRID_CELLS + 1;
+    static const int VERTICES_PER_LEVEL = GRID_VERTICES * GRID_VERTICES;
+
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    GLsizei indexCount = 0;
+
+    std::array<Level, LEVEL_COUNT> levels;
+    HorizonSampler sampler;
+    float innerRadius = 0.0f;
+
+    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Texture> atlas;
+    // Average atlas color of each block's top and side faces
+    ColorTable topColors;
+    ColorTable sideColors;
+
+    static int getSpacing(int level) { return BASE_SPACING << level; }
+    // Radius a level fully covers however its grid snapped around the camera
+    static float getCoverage(int level) { return float((GRID_CELLS / 2 - 2) * getSpacing(level)); }
+    static glm::ivec2 snapCenter(const glm::vec3 &position, int level);
+
+    void waitForPending();
+    // Runs on a background thread; everything it reads is passed in by value
+    static std::vector<HorizonVertex> buildLevel(HorizonSampler sampler, ColorTable topColors, ColorTable sideColors,
+                                                 glm::ivec2 center, int level);
+};
+
+#endif // HORIZON_RENDERER_H
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+#include "occlusionCuller.h"
+#include "../Util/parallel.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OCCLUSION_USE_SSE 1
+#endif
+
+static_assert(OcclusionCuller::WIDTH % 4 == 0, "Rows are processed four pixels at a time");
+static_assert(OcclusionCuller::HEIGHT % OcclusionCuller::BAND_HEIGHT == 0, "Bands must tile the buffer");
+
+namespace
+{
+    const float NEAR_W = 0.1f;           // Boxes reaching closer than this are never used or culled
+    const float DEPTH_TOLERANCE = 1e-4f; // Relative 1/w margin before a box counts as hidden
+    const int TEST_BATCH = 32;           // Chunks tested per task
+    const unsigned int MAX_THREADS = 4;
+
+    // Screen x, screen y, 1/w, w
+    glm::vec4 toScreen(const glm::mat4 &viewProjection, const glm::vec3 &point)
+    {
+        glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        float invW = 1.0f / clip.w;
+        return glm::vec4((clip.x * invW * 0.5f + 0.5f) * OcclusionCuller::WIDTH,
+                         (clip.y * invW * 0.5f + 0.5f) * OcclusionCuller::HEIGHT,
+                         invW, clip.w);
+    }
+
+    glm::vec3 boxCorner(const glm::vec3 &min, const glm::vec3 &max, int corner)
+    {
+        return glm::vec3(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+    }
+
+    unsigned int getThreadCount()
+    {
+        return std::min(MAX_THREADS, getDefaultWorkerCount());
+    }
+
+    // Height of the box from y = 0 that is filled with opaque blocks, or 0 for none.
+    // Generated columns are solid from the bottom up to their top, so the lowest column
+    // top bounds such a box; an edit can hollow a column out under its top, so edited
+    // chunks aren't used.
+    int getOccluderHeight(const Chunk &chunk)
+    {
+        if (chunk.isModified())
+            return 0;
+        return chunk.getHeightmap().getMinOpaque() + 1;
+    }
+}
+
+OcclusionCuller::OcclusionCuller() : depthBuffer(WIDTH * HEIGHT, 0.0f)
+{
+}
+
+void OcclusionCuller::cull(std::vector<std::shared_ptr<Chunk>> &chunks, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition)
+{
+    lastCulled = 0;
+    lastOccluders = 0;
+    if (!enabled || chunks.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Nearest chunks make the best occluders, and chunks arrive sorted nearest first
+    occluders.clear();
+    for (const auto &chunk : chunks)
+    {
+        if (static_cast<int>(occluders.size()) >= occluderLimit)
+            break;
+        int floor = getOccluderHeight(*chunk);
+        if (floor > 0)
+        {
+            glm::vec3 position = chunk->getPosition();
+            occluders.push_back({glm::ivec2(static_cast<int>(std::floor(position.x / Chunk::CHUNK_SIZE)),
+                                            static_cast<int>(std::floor(position.z / Chunk::CHUNK_SIZE))),
+                                 floor});
+        }
+    }
+    lastOccluders = static_cast<int>(occluders.size());
+
+    // Merge runs of neighbouring chunks along x that share a floor into one box,
+    // so conservative rasterization doesn't leave cracks along every chunk border
+    std::sort(occluders.begin(), occluders.end(), [](const Occluder &a, const Occluder &b)
+              { return std::tie(a.grid.y, a.floor, a.grid.x) < std::tie(b.grid.y, b.floor, b.grid.x); });
+    quads.clear();
+    for (std::size_t i = 0; i < occluders.size();)
+    {
+        std::size_t end = i + 1;
+        while (end < occluders.size() && occluders[end].grid.y == occluders[i].grid.y &&
+               occluders[end].floor == occluders[i].floor && occluders[end].grid.x == occluders[end - 1].grid.x + 1)
+            end++;
+        glm::vec3 min(occluders[i].grid.x * Chunk::CHUNK_SIZE, 0.0f, occluders[i].grid.y * Chunk::CHUNK_SIZE);
+        glm::vec3 max((occluders[end - 1].grid.x + 1) * Chunk::CHUNK_SIZE, occluders[i].floor, min.z + Chunk::CHUNK_SIZE);
+        addOccluder(min, max, viewProjection, cameraPosition);
+        i = end;
+    }
+
+    if (!pool)
+        pool = std::make_unique<WorkerPool>(getThreadCount());
+
+    std::fill(depthBuffer.begin(), depthBuffer.end(), 0.0f);
+    pool->run(HEIGHT / BAND_HEIGHT, [this](std::size_t band)
+              { rasterizeBand(static_cast<int>(band)); });
+
+    visible.assign(chunks.size(), 1);
+    std::size_t batches = (chunks.size() + TEST_BATCH - 1) / TEST_BATCH;
+    pool->run(batches, [&](std::size_t batch)
+              {
+        std::size_t end = std::min(chunks.size(), (batch + 1) * TEST_BATCH);
+        for (std::size_t i = batch * TEST_BATCH; i < end; i++)
+        {
+            glm::vec3 min, max;
+            if (chunks[i]->getBounds(min, max))
+                visible[i] = isBoxVisible(min, max, viewProjection);
+        } });
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < chunks.size(); i++)
+    {
+        if (visible[i])
+            chunks[kept++] = std::move(chunks[i]);
+    }
+    lastCulled = static_cast<int>(chunks.size() - kept);
+    chunks.resize(kept);
+
+    // Trade occluders for time: shrink quickly when over budget, grow slowly when well under
+    lastTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (lastTimeMs > budgetMs)
+        occluderLimit = std::max(8, occluderLimit * 3 / 4);
+    else if (lastTimeMs < budgetMs * 0.5 && lastOccluders >= occluderLimit)
+        occluderLimit = std::min(1024, occluderLimit + 8);
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition)
+{
+    glm::vec4 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        corners[i] = toScreen(viewProjection, boxCorner(min, max, i));
+        if (corners[i].w < NEAR_W)
+            return; // Clipping isn't worth it for an occluder
+    }
+
+    // Only faces turned towards the camera; each lists its corners in cycle order
+    const int faces[6][4] = {
+        {0, 2, 6, 4}, {1, 3, 7, 5}, // -X, +X
+        {0, 1, 5, 4}, {2, 3, 7, 6}, // -Y, +Y
+        {0, 1, 3, 2}, {4, 5, 7, 6}, // -Z, +Z
+    };
+    const bool facing[6] = {
+        cameraPosition.x < min.x, cameraPosition.x > max.x,
+        cameraPosition.y < min.y, cameraPosition.y > max.y,
+        cameraPosition.z < min.z, cameraPosition.z > max.z,
+    };
+    for (int f = 0; f < 6; f++)
+    {
+        if (facing[f])
+            addQuad(corners[faces[f][0]], corners[faces[f][1]], corners[faces[f][2]], corners[faces[f][3]]);
+    }
+}
+
+void OcclusionCuller::addQuad(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c, const glm::vec4 &d)
+{
+    glm::vec4 points[4] = {a, b, c, d};
+    float area = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        const glm::vec4 &p = points[i];
+        const glm::vec4 &q = points[(i + 1) % 4];
+        area += p.x * q.y - q.x * p.y;
+    }
+    if (std::abs(area) < 1e-6f)
+        return;
+    // Make the winding counter-clockwise so every edge function is positive inside
+    if (area < 0.0f)
+        std::swap(points[1], points[3]);
+
+    ScreenQuad quad;
+    glm::vec2 screenMin(points[0]), screenMax(points[0]);
+    for (int i = 1; i < 4; i++)
+    {
+        screenMin = glm::min(screenMin, glm::vec2(points[i]));
+        screenMax = glm::max(screenMax, glm::vec2(points[i]));
+    }
+    quad.minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    quad.maxX = std::min(WIDTH - 1, static_cast<int>(std::floor(screenMax.x)));
+    quad.minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    quad.maxY = std::min(HEIGHT - 1, static_cast<int>(std::floor(screenMax.y)));
+    if (quad.minX > quad.maxX || quad.minY > quad.maxY)
+        return;
+
+    for (int i = 0; i < 4; i++)
+    {
+        const glm::vec4 &from = points[i];
+        const glm::vec4 &to = points[(i + 1) % 4];
+        float dx = to.x - from.x;
+        float dy = to.y - from.y;
+        // Evaluated at a pixel centre, this is the edge function at the pixel's most outside corner
+        float shrink = 0.5f * (std::abs(dx) + std::abs(dy));
+        quad.edges[i] = glm::vec3(-dy, dx, dy * from.x - dx * from.y - shrink);
+    }
+
+    // 1/w is affine over a planar face, so three corners define it
+    const glm::vec4 &p0 = points[0], &p1 = points[1], &p2 = points[2];
+    float det = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+    if (std::abs(det) < 1e-6f)
+        return;
+    float dzdx = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / det;
+    float dzdy = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / det;
+    float farthest = 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+    quad.depth = glm::vec3(dzdx, dzdy, p0.z - dzdx * p0.x - dzdy * p0.y - farthest);
+
+    quads.push_back(quad);
+}
+
+void OcclusionCuller::rasterizeBand(int band)
+{
+    int bandMinY = band * BAND_HEIGHT;
+    int bandMaxY = bandMinY + BAND_HEIGHT - 1;
+
+    for (const auto &quad : quads)
+    {
+        int minY = std::max(quad.minY, bandMinY);
+        int maxY = std::min(quad.maxY, bandMaxY);
+        int minX = quad.minX & ~3;
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            float py = y + 0.5f;
+            float *row = &depthBuffer[y * WIDTH];
+#ifdef OCCLUSION_USE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            __m128 edgeX[4], edgeRow[4];
+            for (int e = 0; e < 4; e++)
+            {
+                edgeX[e] = _mm_set1_ps(quad.edges[e].x);
+                edgeRow[e] = _mm_set1_ps(quad.edges[e].y * py + quad.edges[e].z);
+            }
+            __m128 depthX = _mm_set1_ps(quad.depth.x);
+            __m128 depthRow = _mm_set1_ps(quad.depth.y * py + quad.depth.z);
+            for (int x = minX; x <= quad.maxX; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(px, edgeX[0]), edgeRow[0]), zero);
+                for (int e = 1; e < 4; e++)
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(px, edgeX[e]), edgeRow[e]), zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+                __m128 z = _mm_add_ps(_mm_mul_ps(px, depthX), depthRow);
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 closer = _mm_max_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int x = minX; x <= quad.maxX; x++)
+            {
+                glm::vec3 pixel(x + 0.5f, py, 1.0f);
+                bool inside = true;
+                for (int e = 0; e < 4 && inside; e++)
+                    inside = glm::dot(quad.edges[e], pixel) >= 0.0f;
+                if (inside)
+                    row[x] = std::max(row[x], glm::dot(quad.depth, pixel));
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionCuller::isBoxVisible(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &viewProjection) const
+{
+    glm::vec2 screenMin(WIDTH, HEIGHT);
+    glm::vec2 screenMax(0.0f);
+    float nearest = 0.0f;
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec4 corner = toScreen(viewProjection, boxCorner(min, max, i));
+        if (corner.w < NEAR_W)
+            return true;
+        screenMin = glm::min(screenMin, glm::vec2(corner));
+        screenMax = glm::max(screenMax, glm::vec2(corner));
+        nearest = std::max(nearest, corner.z);
+    }
+
+    int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    int maxX = std::min(WIDTH - 1, static_cast<int>(std::floor(screenMax.x)));
+    int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    int maxY = std::min(HEIGHT - 1, static_cast<int>(std::floor(screenMax.y)));
+    if (minX > maxX || minY > maxY)
+        return true;
+
+    // Hidden only if every covered pixel holds an occluder closer than the box's nearest point
+    float threshold = nearest * (1.0f + DEPTH_TOLERANCE);
+    for (int y = minY; y <= maxY; y++)
+    {
+        const float *row = &depthBuffer[y * WIDTH];
+        int x = minX;
+#ifdef OCCLUSION_USE_SSE
+        const __m128 limit = _mm_set1_ps(threshold);
+        for (; x + 3 <= maxX; x += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), limit)) != 0)
+                return true;
+        }
+#endif
+        for (; x <= maxX; x++)
+        {
+            if (row[x] <= threshold)
+                return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../World/chunk.h"
+#include "../Util/workerPool.h"
+
+// Software occlusion culling. The solid lower part of nearby chunks, read off their
+// heightmaps, is rasterized into a small CPU depth buffer, and chunks whose bounds are behind it everywhere
+// on screen are dropped before they reach the renderer.
+// Depth is stored as 1/w (larger is closer), which interpolates linearly across the screen.
+// Occluders are rasterized conservatively: a pixel is only written when the face covers
+// all of it, with the farthest depth inside it, so slivers thinner than a pixel never vanish.
+class OcclusionCuller
+{
+public:
+    static const int WIDTH = 256;
+    static const int HEIGHT = 128;
+    static const int BAND_HEIGHT = 16; // Rows rasterized per task
+
+    OcclusionCuller();
+
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // Time allowed per frame; the occluder count adapts to stay within it
+    void setBudget(double milliseconds) { budgetMs = milliseconds; }
+    double getBudget() const { return budgetMs; }
+
+    // Removes chunks hidden behind the occluders of the chunks in front of them.
+    // Expects `chunks` sorted nearest first, as World::getVisibleChunks returns them.
+    void cull(std::vector<std::shared_ptr<Chunk>> &chunks, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition);
+
+    int getLastCulledCount() const { return lastCulled; }
+    int getLastOccluderCount() const { return lastOccluders; }
+    double getLastTimeMs() const { return lastTimeMs; }
+
+private:
+    // One face of an occluder box projected to the screen; faces are planar, so convex
+    struct ScreenQuad
+    {
+        glm::vec3 edges[4]; // Edge functions (x, y, 1), already shrunk by half a pixel
+        glm::vec3 depth;    // 1/w plane, already lowered to a pixel's farthest corner
+        int minX, maxX, minY, maxY;
+    };
+
+    struct Occluder
+    {
+        glm::ivec2 grid; // Chunk grid coordinates
+        int floor;       // Opaque layers from y = 0
+    };
+
+    bool enabled = true;
+    double budgetMs = 1.0;
+    int occluderLimit = 64;
+
+    std::vector<float> depthBuffer;
+    std::vector<Occluder> occluders;
+    std::vector<ScreenQuad> quads;
+    std::vector<uint8_t> visible;
+    std::unique_ptr<WorkerPool> pool; // Started on the first cull, kept for the culler's life
+
+    int lastCulled = 0;
+    int lastOccluders = 0;
+    double lastTimeMs = 0.0;
+
+    void addOccluder(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition);
+    void addQuad(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c, const glm::vec4 &d);
+    void rasterizeBand(int band);
+    bool isBoxVisible(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &viewProjection) const;
+};
+
+#endif // OCCLUSION_CULLER_H
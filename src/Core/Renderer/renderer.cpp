@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 #include "renderer.h"
 #include "../assets.h"
@@ -8,7 +9,7 @@ Renderer::Renderer() :
     window(nullptr),
     curShader(nullptr),
     viewMatrix(1.0f),
-    projectionMatrix(glm::perspective(glm::radians(45.0f), 800.0f/600.0f, 0.1f, 1000.0f))
+    projectionMatrix(glm::perspective(glm::radians(45.0f), 800.0f/600.0f, 0.1f, 2048.0f))
 {
 }
 Renderer::~Renderer() {
@@ -19,7 +20,8 @@ Renderer::~Renderer() {
 void framebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     Renderer *renderer = static_cast<Renderer *>(glfwGetWindowUserPointer(window));
-    if (renderer && renderer->getAutomaticViewport())
+    // Headless frames go to a fixed-size framebuffer, whatever the hidden window does
+    if (renderer && renderer->getAutomaticViewport() && !renderer->isHeadless())
     {
         renderer->setScrSize(width, height);
         glViewport(0, 0, width, height);
@@ -126,12 +128,26 @@ void Renderer::initialize()
         return;
     }
 
-    // Initialize GLFW
-    if (!glfwInit())
+    // Initialize GLFW; headless runs on machines without a display fall back to GLFW's
+    // null platform, which gets its context from EGL (surfaceless on Mesa)
+    bool initialized = glfwInit();
+    if (!initialized && headless && glfwPlatformSupported(GLFW_PLATFORM_NULL))
+    {
+        std::cerr << "No display, creating a surfaceless context" << std::endl;
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        initialized = glfwInit();
+    }
+    if (!initialized)
     {
         throw std::runtime_error("Failed to initialize GLFW");
     }
 
+    if (headless)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE); // GLFW_OPENGL_CORE_PROFILE
@@ -168,14 +184,88 @@ if (glfwExtensionSupported("GL_ARB_debug_output"))
 #endif
 
 
+    // Fresh context: nothing cached is true anymore
+    auto &gl = GLState::getInstance();
+    gl.reset();
+
+    projectionMatrix = glm::perspective(glm::radians(45.0f), float(SCR_WIDTH) / float(SCR_HEIGHT), 0.1f, 2048.0f);
+    if (headless)
+    {
+        // Nothing is shown, so nothing should wait for a display either
+        glfwSwapInterval(0);
+        createOffscreenTarget();
+    }
+    if (!GLState::hasDSA())
+        std::cerr << "OpenGL 4.5 unavailable, editing GL objects through binds" << std::endl;
+
     // Set default OpenGL state
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl.setCapability(GL_DEPTH_TEST, true);
+    gl.setCapability(GL_BLEND, true);
+    gl.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    cameraBuffer = GLState::createBuffer();
+    GLState::bufferData(cameraBuffer, sizeof(CameraUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, Shader::CAMERA_BLOCK_BINDING, cameraBuffer);
+    instanceBuffer = GLState::createBuffer();
+
+    horizonRenderer = std::make_shared<HorizonRenderer>();
+    if (TerrainRenderer::isSupported())
+        terrainRenderer = std::make_shared<TerrainRenderer>();
+    else
+        std::cerr << "OpenGL 4.3 unavailable, drawing terrain one chunk at a time" << std::endl;
 
     isInitialized = true;
 }
 
+void Renderer::createOffscreenTarget()
+{
+    glGenRenderbuffers(1, &offscreenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT);
+    glGenRenderbuffers(1, &offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &offscreenFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error("Offscreen framebuffer incomplete");
+    }
+    // Stays bound for good; everything draws into it
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+}
+
+void Renderer::present()
+{
+    VOXELC_TRACE_SCOPE("present", "render");
+    if (!headless)
+    {
+        glfwSwapBuffers(window);
+        return;
+    }
+    // No swap chain to hold the CPU back, so wait for the frame that used this slot
+    // last; the GPU then never falls more than FRAMES_IN_FLIGHT frames behind
+    GLsync &fence = frameFences[fenceIndex];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    fenceIndex = (fenceIndex + 1) % FRAMES_IN_FLIGHT;
+}
+
+bool Renderer::shouldClose() const
+{
+    // Nobody can close an invisible window; headless runs end on their own terms
+    return !window || (!headless && glfwWindowShouldClose(window));
+}
+
 void Renderer::setInputMode(int mode, int value)
 {
     if (!window)
@@ -185,17 +275,22 @@ void Renderer::setInputMode(int mode, int value)
 
 void Renderer::enableCapability(int capability)
 {
-    glEnable(capability);
+    GLState::getInstance().setCapability(capability, true);
 }
 
 void Renderer::disableCapability(int capability)
 {
-    glDisable(capability);
+    GLState::getInstance().setCapability(capability, false);
 }
 
 void Renderer::setBlendFunc(int sfactor, int dfactor)
 {
-    glBlendFunc(sfactor, dfactor);
+    GLState::getInstance().setBlendFunc(sfactor, dfactor);
+}
+
+void Renderer::setDepthMask(bool enable)
+{
+    GLState::getInstance().setDepthMask(enable);
 }
 
 void Renderer::setAutomaticViewport(bool enable)
@@ -208,6 +303,12 @@ void Renderer::setViewport(int x, int y, int width, int height)
     glViewport(x, y, width, height);
 }
 
+void Renderer::setFog(const glm::vec3 &color, float distance)
+{
+    fogColor = color;
+    fogDistance = distance;
+}
+
 void Renderer::setShader(const std::string &shaderName)
 {
     auto &assetMgr = AssetManager::getInstance();
@@ -226,16 +327,40 @@ void Renderer::beginFrame(glm::mat4 viewMatrix)
     }
 
     this->viewMatrix = viewMatrix;
+    // Close the books on the previous frame
+    auto &counters = GLState::getInstance().getCounters();
+    frameStats.counters = counters;
+    counters = RenderCounters();
+    for (int pass = 0; pass < RENDER_PASS_COUNT; pass++)
+        frameStats.gpuMs[pass] = passTimers[pass].getMs();
+
     batches.clear();
+    if (terrainRenderer)
+        terrainRenderer->beginFrame();
     isFrameStarted = true;
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    // Everything every shader reads per frame, in one upload
+    CameraUniforms camera;
+    camera.view = viewMatrix;
+    camera.projection = projectionMatrix;
+    camera.screen = glm::ortho(0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f);
+    camera.cameraPosition = glm::inverse(viewMatrix)[3];
+    camera.fogColor = glm::vec4(fogColor, 1.0f);
+    camera.fogParams = glm::vec4(fogDistance, 0.0f, 0.0f, 0.0f);
+    GLState::bufferSubData(cameraBuffer, 0, sizeof(CameraUniforms), &camera);
+    horizonRenderer->update(glm::vec3(camera.cameraPosition));
+
+    // Sky matches the fog, so the horizon fades into it instead of ending in an edge
+    glClearColor(fogColor.r, fogColor.g, fogColor.b, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void Renderer::renderMesh(std::shared_ptr<UV_VertexBuffer> buffer,
                           std::shared_ptr<Texture> texture,
-                          std::shared_ptr<Transform> transform)
+                          std::shared_ptr<Transform> transform,
+                          unsigned int firstIndex,
+                          unsigned int indexCount,
+                          std::shared_ptr<Shader> shader)
 {
     if (!isFrameStarted)
     {
@@ -251,7 +376,10 @@ void Renderer::renderMesh(std::shared_ptr<UV_VertexBuffer> buffer,
     RenderBatch batch{
         buffer,
         texture,
-        transform};
+        transform,
+        firstIndex,
+        indexCount,
+        shader ? shader : curShader};
     batches.push_back(batch);
 }
 
@@ -267,52 +395,187 @@ void Renderer::endFrame()
         throw std::runtime_error("No shader set");
     }
 
-    // Render all batches
-    curShader->use();
-    curShader->setMat4("view", viewMatrix);
-    curShader->setMat4("projection", projectionMatrix);
+    // The horizon gets a depth range of its own; chunks then start from a clear depth
+    // buffer and cover it wherever they exist
+    if (horizonRenderer->hasMaterial())
+    {
+        beginPass(RENDER_PASS_HORIZON);
+        horizonRenderer->draw(projectionMatrix);
+        GLState::getInstance().setDepthMask(true);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        endPass(RENDER_PASS_HORIZON);
+    }
+
+    // All terrain goes out in one multi-draw before the individual batches
+    if (terrainRenderer)
+    {
+        beginPass(RENDER_PASS_TERRAIN);
+        terrainRenderer->draw();
+        endPass(RENDER_PASS_TERRAIN);
+    }
+
+    // Render all batches; view and projection come from the Camera block
+    beginPass(RENDER_PASS_MESHES);
+    buildGroups();
+    if (!instanceMatrices.empty())
+    {
+        // Orphaned and refilled in one go; every instanced group reads its slice of it
+        if (instanceMatrices.size() > instanceCapacity)
+            instanceCapacity = std::max(instanceMatrices.size(), instanceCapacity * 2);
+        GLState::bufferData(instanceBuffer, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        GLState::bufferSubData(instanceBuffer, 0, instanceMatrices.size() * sizeof(glm::mat4), instanceMatrices.data());
+    }
+    batchDrawCount = 0;
+    batchMeshCount = batches.size();
+    for (const auto &group : groups)
+        drawGroup(group);
+    GLState::getInstance().bindVertexArray(0);
+    endPass(RENDER_PASS_MESHES);
+
+    //glfwSwapBuffers(window);
+    isFrameStarted = false;
+}
+
+void Renderer::beginPass(RenderPass pass)
+{
+    passTraceStart[pass] = TraceRecorder::now();
+    passTimers[pass].begin();
+}
+
+void Renderer::endPass(RenderPass pass)
+{
+    passTimers[pass].end();
+    TraceRecorder::record(getRenderPassName(pass), "render", passTraceStart[pass], TraceRecorder::now());
+}
+
+// Sorts the frame's batches so identical draws sit next to each other, then merges runs
+// that an instanced shader can draw at once. Runs of the setShader shader switch to its
+// instanced twin. Their model matrices are laid out in group order in instanceMatrices;
+// other batches stay groups of one and use the "model" uniform.
+void Renderer::buildGroups()
+{
+    groups.clear();
+    instanceMatrices.clear();
 
+    struct Resolved
+    {
+        std::shared_ptr<Shader> shader;
+        std::shared_ptr<UV_VertexBuffer> buffer;
+        std::shared_ptr<Texture> texture;
+        std::shared_ptr<Transform> transform;
+        unsigned int firstIndex;
+        GLsizei indexCount;
+    };
+    std::vector<Resolved> resolved;
+    resolved.reserve(batches.size());
     for (const auto &batch : batches)
     {
-        auto buffer = batch.buffer.lock();
-        auto texture = batch.texture.lock();
-        auto transform = batch.transform.lock();
+        Resolved entry{batch.shader.lock(), batch.buffer.lock(), batch.texture.lock(), batch.transform.lock(), batch.firstIndex, 0};
         // Skip invalid batches
-        if (!buffer || !buffer->isValid() || !texture || !transform) {
+        if (!entry.shader || !entry.buffer || !entry.buffer->isValid() || !entry.texture || !entry.transform)
             continue;
-        }
-        if (texture)
+        entry.indexCount = batch.indexCount > 0 ? batch.indexCount : entry.buffer->getIndexCount();
+        resolved.push_back(std::move(entry));
+    }
+
+    auto key = [](const Resolved &entry)
+    { return std::make_tuple(entry.shader.get(), entry.buffer.get(), entry.texture.get(), entry.firstIndex, entry.indexCount); };
+    std::stable_sort(resolved.begin(), resolved.end(), [&](const Resolved &a, const Resolved &b)
+                     { return key(a) < key(b); });
+
+    bool canSwap = instancedShader && instancedShader->isInstanced();
+    for (std::size_t i = 0; i < resolved.size();)
+    {
+        const Resolved &first = resolved[i];
+        std::size_t end = i + 1;
+        if (first.shader->isInstanced() || (canSwap && first.shader == curShader))
         {
-            texture->bind();
-            texture->bindToShaderInt(*curShader, "texture0");
+            while (end < resolved.size() && key(resolved[end]) == key(first))
+                end++;
         }
 
-        curShader->setMat4("model", transform->getMatrix());
-
-        buffer->bind();
-        //std::cout << "Drawing " << buffer->getIndexCount() << " indices" << std::endl;
-        //auto buffers = buffer->getBuffers();
-        /*
-        std::cout << "Buffer IDs: (" 
-                  << std::get<0>(buffers) << ", " 
-                  << std::get<1>(buffers) << ", " 
-                  << std::get<2>(buffers) << ")" << std::endl;
-        */
-        glDrawElements(GL_TRIANGLES, buffer->getIndexCount(), GL_UNSIGNED_INT, 0);
-        buffer->unbind();
-
-        if (texture)
+        // A single copy keeps its own shader; the swap only pays off for two or more
+        std::shared_ptr<Shader> shader = first.shader;
+        if (!shader->isInstanced() && end - i > 1)
+            shader = instancedShader;
+
+        BatchGroup group{shader, first.buffer, first.texture, first.firstIndex, first.indexCount,
+                         instanceMatrices.size(), end - i, first.transform->getMatrix()};
+        if (shader->isInstanced())
         {
-            texture->unbind();
+            for (std::size_t j = i; j < end; j++)
+                instanceMatrices.push_back(resolved[j].transform->getMatrix());
         }
+        groups.push_back(std::move(group));
+        i = end;
     }
+}
 
-    //glfwSwapBuffers(window);
-    isFrameStarted = false;
+void Renderer::drawGroup(const BatchGroup &group)
+{
+    group.shader->use();
+    group.shader->setInt("texture0", 0);
+    // Unit 0 every time; the state cache drops the bind when the texture is already there
+    group.texture->bind(0);
+    group.buffer->bind();
+    const void *indices = reinterpret_cast<const void *>(static_cast<uintptr_t>(group.firstIndex) * sizeof(unsigned int));
+    batchDrawCount++;
+
+    if (!group.shader->isInstanced())
+    {
+        group.shader->setMat4("model", group.model);
+        glDrawElements(GL_TRIANGLES, group.indexCount, GL_UNSIGNED_INT, indices);
+        GLState::getInstance().countDraw(group.indexCount);
+        return;
+    }
+
+    GLsizei count = static_cast<GLsizei>(group.instanceCount);
+    GLState::getInstance().countDraw(group.indexCount, group.instanceCount);
+    if (GLAD_GL_VERSION_4_2)
+    {
+        // The attribute always starts at the top of the buffer; baseInstance picks the slice
+        group.buffer->setInstanceBuffer(instanceBuffer, Shader::INSTANCE_MODEL_LOCATION);
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, group.indexCount, GL_UNSIGNED_INT, indices, count,
+                                            static_cast<GLuint>(group.firstInstance));
+    }
+    else
+    {
+        group.buffer->setInstanceBuffer(instanceBuffer, Shader::INSTANCE_MODEL_LOCATION, group.firstInstance * sizeof(glm::mat4));
+        glDrawElementsInstanced(GL_TRIANGLES, group.indexCount, GL_UNSIGNED_INT, indices, count);
+    }
 }
 
 void Renderer::cleanup()
 {
+    // GL objects must go before the context does
+    terrainRenderer.reset();
+    horizonRenderer.reset();
+    if (cameraBuffer)
+    {
+        glDeleteBuffers(1, &cameraBuffer);
+        cameraBuffer = 0;
+    }
+    if (instanceBuffer)
+    {
+        glDeleteBuffers(1, &instanceBuffer);
+        instanceBuffer = 0;
+        instanceCapacity = 0;
+    }
+    for (auto &timer : passTimers)
+        timer.release();
+    for (auto &fence : frameFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (offscreenFramebuffer)
+    {
+        glDeleteFramebuffers(1, &offscreenFramebuffer);
+        glDeleteRenderbuffers(1, &offscreenColor);
+        glDeleteRenderbuffers(1, &offscreenDepth);
+        offscreenFramebuffer = offscreenColor = offscreenDepth = 0;
+    }
     if (window)
     {
         glfwDestroyWindow(window);
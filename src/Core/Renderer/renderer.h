@@ -6,8 +6,25 @@
 #include <tuple>
 #include "../Rendering/texture.h"
 #include "../transform.h"
+#include "terrainRenderer.h"
+#include "horizonRenderer.h"
 #include "../Rendering/vertexBuffer.h"
 #include "../Rendering/texture.h"
+#include "../Rendering/gpuTimer.h"
+#include "../Rendering/renderStats.h"
+#include "../Debug/traceRecorder.h"
+
+// Layout of the std140 Camera uniform block declared in the shaders; mat4 and vec4
+// members only, so the C++ layout matches without padding
+struct CameraUniforms
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 screen;         // Pixel-space ortho for 2D, origin top left
+    glm::vec4 cameraPosition; // xyz
+    glm::vec4 fogColor;       // rgb
+    glm::vec4 fogParams;      // x = fog distance
+};
 
 class Renderer : public std::enable_shared_from_this<Renderer>
 {
@@ -15,24 +32,57 @@ public:
     Renderer();
     ~Renderer();
 
+    // Before initialize: render into an offscreen framebuffer of the screen size set
+    // with setScrSize, from an invisible window, with no vsync
+    void setHeadless(bool enable) { headless = enable; }
+    bool isHeadless() const { return headless; }
     void initialize();
     GLFWwindow *getWindow() { return window; }
+    // Shows the frame, or in headless mode just keeps the GPU from falling too far behind
+    void present();
+    bool shouldClose() const;
     void setInputMode(int mode, int value);
     void enableCapability(int capability);
     void disableCapability(int capability);
     void setBlendFunc(int sfactor, int dfactor);
+    void setDepthMask(bool enable);
     void setAutomaticViewport(bool enable);
     bool getAutomaticViewport() const { return automaticViewport; }
     void setViewport(int x, int y, int width, int height);
     void setShader(const std::string &shaderName);
     void setShader(std::shared_ptr<Shader> shader) { curShader = shader; }
+    // Instanced twin of the setShader one (same look, model matrix from aModel). A mesh
+    // submitted more than once in a frame with the setShader one is drawn with this
+    // instead, so all its copies go out as one instanced draw.
+    void setInstancedShader(std::shared_ptr<Shader> shader) { instancedShader = shader; }
     void setScrSize(unsigned int width, unsigned int height) { SCR_WIDTH = width; SCR_HEIGHT = height; }
     std::tuple<unsigned int, unsigned int> getScrSize() const { return std::make_tuple(SCR_WIDTH, SCR_HEIGHT); }
+    const glm::mat4 &getProjectionMatrix() const { return projectionMatrix; }
+    void setFog(const glm::vec3 &color, float distance);
+    // Null when the context can't multi-draw; chunks then fall back to renderMesh
+    std::shared_ptr<TerrainRenderer> getTerrainRenderer() const { return terrainRenderer; }
+    // Far terrain drawn behind everything else; does nothing until given a material and sampler
+    std::shared_ptr<HorizonRenderer> getHorizonRenderer() const { return horizonRenderer; }
     void beginFrame(glm::mat4 viewMatrix);
-    void renderMesh(std::shared_ptr<UV_VertexBuffer> buffer, std::shared_ptr<Texture> texture, std::shared_ptr<Transform> transform);
+    // Draws indices [firstIndex, firstIndex + indexCount) of the buffer; indexCount = 0 draws all of them.
+    // A null shader means the one given to setShader. Submissions that share buffer, range,
+    // texture and an instanced shader (Shader::isInstanced, or the setShader one when
+    // setInstancedShader was given its twin) go out as one instanced draw.
+    void renderMesh(std::shared_ptr<UV_VertexBuffer> buffer, std::shared_ptr<Texture> texture, std::shared_ptr<Transform> transform,
+                    unsigned int firstIndex = 0, unsigned int indexCount = 0, std::shared_ptr<Shader> shader = nullptr);
+    // Draw calls issued by the last endFrame for the batched meshes, and how many meshes they covered
+    std::size_t getBatchDrawCount() const { return batchDrawCount; }
+    std::size_t getBatchMeshCount() const { return batchMeshCount; }
     void endFrame();
     void cleanup();
 
+    // GPU-times work drawn outside endFrame (the UI); passes can't overlap
+    void beginPass(RenderPass pass);
+    void endPass(RenderPass pass);
+    // Counters of the last whole frame (beginFrame to beginFrame, so the UI is included)
+    // and the latest GPU time of each pass
+    const RenderStats &getFrameStats() const { return frameStats; }
+
 private:
     // Move constructor to private section and make it inline
     struct RenderBatch
@@ -40,15 +90,60 @@ private:
         std::weak_ptr<UV_VertexBuffer> buffer;
         std::weak_ptr<Texture> texture;
         std::weak_ptr<Transform> transform;
+        unsigned int firstIndex;
+        unsigned int indexCount;
+        std::weak_ptr<Shader> shader;
+    };
+
+    // Batches that can share one draw: same shader, buffer, texture and index range
+    struct BatchGroup
+    {
+        std::shared_ptr<Shader> shader;
+        std::shared_ptr<UV_VertexBuffer> buffer;
+        std::shared_ptr<Texture> texture;
+        unsigned int firstIndex;
+        GLsizei indexCount;
+        std::size_t firstInstance; // Into instanceMatrices
+        std::size_t instanceCount;
+        glm::mat4 model;           // Only for shaders that aren't instanced
     };
 
     std::vector<RenderBatch> batches;
+    std::vector<BatchGroup> groups;
+    std::vector<glm::mat4> instanceMatrices;
+    GLuint instanceBuffer = 0; // Model matrices of every instanced group, rewritten each frame
+    std::size_t instanceCapacity = 0;
+    std::size_t batchDrawCount = 0;
+    std::size_t batchMeshCount = 0;
+
+    void buildGroups();
+    void drawGroup(const BatchGroup &group);
 
     GLFWwindow *window;
     std::shared_ptr<Shader> curShader;
+    std::shared_ptr<Shader> instancedShader;
+    std::shared_ptr<TerrainRenderer> terrainRenderer;
+    std::shared_ptr<HorizonRenderer> horizonRenderer;
 
     glm::mat4 viewMatrix;
     glm::mat4 projectionMatrix;
+    glm::vec3 fogColor{186.0f / 255.0f, 214.0f / 255.0f, 254.0f / 255.0f};
+    float fogDistance = 256.0f;
+    GLuint cameraBuffer = 0; // Camera uniform block, rewritten once per frame
+
+    std::array<GpuTimer, RENDER_PASS_COUNT> passTimers;
+    std::array<std::uint64_t, RENDER_PASS_COUNT> passTraceStart{}; // CPU side of each pass, for the trace
+    RenderStats frameStats;
+
+    static const int FRAMES_IN_FLIGHT = 2;
+    bool headless = false;
+    GLuint offscreenFramebuffer = 0;
+    GLuint offscreenColor = 0;
+    GLuint offscreenDepth = 0;
+    std::array<GLsync, FRAMES_IN_FLIGHT> frameFences{};
+    int fenceIndex = 0;
+
+    void createOffscreenTarget();
 
     unsigned int SCR_WIDTH = 800;
     unsigned int SCR_HEIGHT = 600;
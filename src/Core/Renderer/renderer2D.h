@@ -3,6 +3,7 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <array>
 #include <memory>
 #include <vector>
 #include "../Rendering/shader.h"
@@ -15,33 +16,56 @@ struct Quad2D {
     glm::vec2 size;
     glm::vec4 color;
     std::shared_ptr<Texture> texture;
+    glm::vec2 uv0{0.0f}; // Bottom-left corner
+    glm::vec2 uv1{1.0f}; // Top-right corner
 };
 
 
+// Quads are drawn in submission order from one vertex upload per frame. Each vertex
+// carries the slot of its texture, so a draw covers every quad until a 17th distinct
+// texture shows up; only then is the batch split.
 class Renderer2D: public std::enable_shared_from_this<Renderer2D>
 {
 public:
+    // Texture units one draw can use; GL 3.3 guarantees 16 per fragment shader
+    static const int MAX_TEXTURE_SLOTS = 16;
+
     Renderer2D();
     ~Renderer2D();
 
+    // The pixel-space projection comes from the Renderer's Camera block
     void setShader(std::shared_ptr<Shader> shader);
-    void setProjection(const glm::mat4& proj);
 
     void beginFrame();
     void endFrame();
 
     void drawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
     void drawQuad(const glm::vec2& position, const glm::vec2& size, std::shared_ptr<Texture> texture, const glm::vec4& color = glm::vec4(1.0f));
+    // Part of a texture: uv0 lands on the bottom-left corner, uv1 on the top-right
+    void drawQuad(const glm::vec2& position, const glm::vec2& size, std::shared_ptr<Texture> texture,
+                  const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec4& color = glm::vec4(1.0f));
+
+    // Draw calls issued by the last endFrame
+    std::size_t getDrawCount() const { return drawCount; }
 
 private:
+    // A run of quads sharing one set of texture slots
+    struct DrawRange {
+        std::size_t firstQuad;
+        std::size_t quadCount;
+        std::array<Texture*, MAX_TEXTURE_SLOTS> slots;
+        int slotCount;
+    };
+
     void flush();
 
     std::vector<Quad2D> batch;
+    std::vector<Vertex2D> vertices;
+    std::vector<DrawRange> ranges;
     std::shared_ptr<Shader> shader;
-    GLuint VAO, VBO, EBO;
     std::shared_ptr<VertexBuffer2D> vertexBuffer;
+    std::size_t drawCount = 0;
     bool initialized = false;
-    glm::mat4 projection = glm::mat4(1.0f);
 };
 
-#endif // RENDERER2D_H
\ No newline at end of file
+#endif // RENDERER2D_H
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <stdexcept>
+#include "terrainRenderer.h"
+#include "../Debug/metrics.h"
+
+namespace
+{
+    const std::size_t INITIAL_VERTEX_CAPACITY = 4 * 1024 * 1024;
+    const std::size_t INITIAL_INDEX_CAPACITY = 6 * 1024 * 1024;
+    const std::size_t INITIAL_DRAW_CAPACITY = 1024;
+    const std::size_t UPLOAD_RING_CAPACITY = 32 * 1024 * 1024;
+
+    // Creates a buffer of newSize bytes holding the first oldSize bytes of `buffer`, and deletes the old one
+    GLuint resizeBuffer(GLuint buffer, std::size_t oldSize, std::size_t newSize)
+    {
+        GLuint resized = GLState::createBuffer();
+        GLState::bufferData(resized, newSize, nullptr, GL_STATIC_DRAW);
+        if (buffer && oldSize > 0)
+            GLState::copyBufferSubData(buffer, resized, 0, 0, oldSize);
+        if (buffer)
+            glDeleteBuffers(1, &buffer);
+        return resized;
+    }
+}
+
+TerrainMesh::~TerrainMesh()
+{
+    if (auto renderer = owner.lock())
+        renderer->release(*this);
+}
+
+TerrainRenderer::TerrainRenderer()
+{
+    vao = GLState::createVertexArray();
+    originBuffer = GLState::createBuffer();
+    commandBuffer = GLState::createBuffer();
+    growVertexArena(INITIAL_VERTEX_CAPACITY);
+    growIndexArena(INITIAL_INDEX_CAPACITY);
+    ensureDrawIndices(INITIAL_DRAW_CAPACITY);
+    if (UploadRing::isSupported())
+        uploadRing = std::make_shared<UploadRing>(UPLOAD_RING_CAPACITY);
+}
+
+TerrainRenderer::~TerrainRenderer()
+{
+    uploadRing.reset();
+    GLState::getInstance().forgetVertexArray(vao);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexArena);
+    glDeleteBuffers(1, &indexArena);
+    glDeleteBuffers(1, &drawIndexBuffer);
+    glDeleteBuffers(1, &originBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+}
+
+bool TerrainRenderer::isSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+void TerrainRenderer::setMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> texture)
+{
+    this->shader = shader;
+    this->texture = texture;
+}
+
+std::shared_ptr<TerrainMesh> TerrainRenderer::upload(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                                     const std::shared_ptr<StagedUpload> &staged)
+{
+    if (vertices.empty() || indices.empty())
+        return nullptr;
+
+    std::size_t firstVertex = vertexAllocator.allocate(vertices.size());
+    if (firstVertex == RangeAllocator::INVALID)
+    {
+        growVertexArena(vertexAllocator.getCapacity() + vertices.size());
+        firstVertex = vertexAllocator.allocate(vertices.size());
+    }
+    std::size_t firstIndex = indexAllocator.allocate(indices.size());
+    if (firstIndex == RangeAllocator::INVALID)
+    {
+        growIndexArena(indexAllocator.getCapacity() + indices.size());
+        firstIndex = indexAllocator.allocate(indices.size());
+    }
+    if (firstVertex == RangeAllocator::INVALID || firstIndex == RangeAllocator::INVALID)
+        throw std::runtime_error("Terrain arena allocation failed");
+
+    std::size_t vertexBytes = vertices.size() * sizeof(Vertex);
+    std::size_t indexBytes = indices.size() * sizeof(unsigned int);
+    if (staged && uploadRing && uploadRing->consume(*staged))
+    {
+        // Already in GPU-visible memory: only a copy per buffer on this thread
+        std::size_t source = staged->getOffset();
+        std::size_t indexSource = source + (vertexBytes + UploadRing::ALIGNMENT - 1) / UploadRing::ALIGNMENT * UploadRing::ALIGNMENT;
+        GLState::copyBufferSubData(uploadRing->getBuffer(), vertexArena, source, firstVertex * sizeof(Vertex), vertexBytes);
+        GLState::copyBufferSubData(uploadRing->getBuffer(), indexArena, indexSource, firstIndex * sizeof(unsigned int), indexBytes);
+    }
+    else
+    {
+        GLState::bufferSubData(vertexArena, firstVertex * sizeof(Vertex), vertexBytes, vertices.data());
+        GLState::bufferSubData(indexArena, firstIndex * sizeof(unsigned int), indexBytes, indices.data());
+    }
+
+    auto mesh = std::make_shared<TerrainMesh>();
+    mesh->firstVertex = firstVertex;
+    mesh->vertexCount = vertices.size();
+    mesh->firstIndex = firstIndex;
+    mesh->indexCount = indices.size();
+    mesh->owner = weak_from_this();
+    updateMemoryMetrics();
+    return mesh;
+}
+
+void TerrainRenderer::release(const TerrainMesh &mesh)
+{
+    vertexAllocator.free(mesh.firstVertex, mesh.vertexCount);
+    indexAllocator.free(mesh.firstIndex, mesh.indexCount);
+    updateMemoryMetrics();
+}
+
+void TerrainRenderer::updateMemoryMetrics()
+{
+    static MetricGauge &used = Metrics::gauge("mesh.gpu_bytes");
+    static MetricGauge &reserved = Metrics::gauge("mesh.gpu_arena_bytes");
+    used.set(static_cast<std::int64_t>(vertexAllocator.getUsed() * sizeof(Vertex) + indexAllocator.getUsed() * sizeof(unsigned int)));
+    reserved.set(static_cast<std::int64_t>(vertexAllocator.getCapacity() * sizeof(Vertex) +
+                                           indexAllocator.getCapacity() * sizeof(unsigned int)));
+}
+
+void TerrainRenderer::submit(const TerrainMesh &mesh, const glm::vec3 &origin, std::size_t firstIndex, std::size_t indexCount)
+{
+    if (indexCount == 0 || firstIndex + indexCount > mesh.indexCount)
+        return;
+
+    DrawCommand command;
+    command.count = static_cast<GLuint>(indexCount);
+    command.instanceCount = 1;
+    command.firstIndex = static_cast<GLuint>(mesh.firstIndex + firstIndex);
+    command.baseVertex = static_cast<GLint>(mesh.firstVertex);
+    command.baseInstance = static_cast<GLuint>(commands.size());
+    commands.push_back(command);
+    origins.emplace_back(origin, 0.0f);
+}
+
+void TerrainRenderer::beginFrame()
+{
+    commands.clear();
+    origins.clear();
+    if (uploadRing)
+        uploadRing->beginFrame();
+}
+
+void TerrainRenderer::draw()
+{
+    // Fences this frame's ring copies; they were issued before any draw below
+    if (uploadRing)
+        uploadRing->endFrame();
+    if (commands.empty() || !hasMaterial())
+        return;
+    ensureDrawIndices(commands.size());
+
+    auto &gl = GLState::getInstance();
+    texture->bindToShaderInt(*shader, "texture0");
+
+    GLState::bufferData(originBuffer, origins.size() * sizeof(glm::vec4), origins.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, originBuffer);
+
+    GLState::bufferData(commandBuffer, commands.size() * sizeof(DrawCommand), commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+    gl.bindVertexArray(vao);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+    std::uint64_t indexTotal = 0;
+    for (const auto &command : commands)
+        indexTotal += command.count;
+    gl.countDraw(indexTotal);
+    gl.bindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void TerrainRenderer::growVertexArena(std::size_t minimumCapacity)
+{
+    std::size_t oldCapacity = vertexAllocator.getCapacity();
+    std::size_t newCapacity = std::max(minimumCapacity, oldCapacity * 2);
+    vertexArena = resizeBuffer(vertexArena, oldCapacity * sizeof(Vertex), newCapacity * sizeof(Vertex));
+    vertexAllocator.grow(newCapacity);
+    bindVertexLayout();
+}
+
+void TerrainRenderer::growIndexArena(std::size_t minimumCapacity)
+{
+    std::size_t oldCapacity = indexAllocator.getCapacity();
+    std::size_t newCapacity = std::max(minimumCapacity, oldCapacity * 2);
+    indexArena = resizeBuffer(indexArena, oldCapacity * sizeof(unsigned int), newCapacity * sizeof(unsigned int));
+    indexAllocator.grow(newCapacity);
+    bindVertexLayout();
+}
+
+void TerrainRenderer::ensureDrawIndices(std::size_t count)
+{
+    if (count <= drawIndexCapacity)
+        return;
+    std::size_t capacity = std::max<std::size_t>(drawIndexCapacity * 2, count);
+    std::vector<GLuint> drawIndices(capacity);
+    for (std::size_t i = 0; i < capacity; i++)
+        drawIndices[i] = static_cast<GLuint>(i);
+
+    if (!drawIndexBuffer)
+        drawIndexBuffer = GLState::createBuffer();
+    GLState::bufferData(drawIndexBuffer, capacity * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+    drawIndexCapacity = capacity;
+    bindVertexLayout();
+}
+
+void TerrainRenderer::bindVertexLayout()
+{
+    if (!vertexArena || !indexArena || !drawIndexBuffer)
+        return;
+
+    auto &gl = GLState::getInstance();
+    // Position attribute
+    gl.vertexAttrib(vao, 0, vertexArena, 3, GL_FLOAT, sizeof(Vertex), 0);
+    // Texture coord attribute
+    gl.vertexAttrib(vao, 1, vertexArena, 2, GL_FLOAT, sizeof(Vertex), 3 * sizeof(float));
+    // Draw index, advanced once per instance so each draw reads its baseInstance
+    gl.vertexAttrib(vao, 2, drawIndexBuffer, 1, GL_UNSIGNED_INT, sizeof(GLuint), 0, true, 1);
+    gl.elementBuffer(vao, indexArena);
+}
@@ -0,0 +1,105 @@
+#ifndef TERRAIN_RENDERER_H
+#define TERRAIN_RENDERER_H
+
+#include <glad/glad.h>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../Rendering/shader.h"
+#include "../Rendering/texture.h"
+#include "../Util/vertex.h"
+#include "../Util/rangeAllocator.h"
+#include "uploadRing.h"
+
+class TerrainRenderer;
+
+// A chunk mesh stored in the terrain arena. Indices are relative to firstVertex.
+// The arena space is handed back when the last reference goes away.
+struct TerrainMesh
+{
+    std::size_t firstVertex = 0;
+    std::size_t vertexCount = 0;
+    std::size_t firstIndex = 0;
+    std::size_t indexCount = 0;
+    std::weak_ptr<TerrainRenderer> owner;
+
+    ~TerrainMesh();
+};
+
+// Draws every chunk with a single glMultiDrawElementsIndirect call (GL 4.3).
+// All chunk meshes share one vertex buffer and one index buffer, carved up by
+// RangeAllocator. Chunk origins go in an SSBO that the vertex shader indexes with
+// the draw's baseInstance, fed through an instanced vertex attribute.
+class TerrainRenderer : public std::enable_shared_from_this<TerrainRenderer>
+{
+public:
+    TerrainRenderer();
+    ~TerrainRenderer();
+
+    // True when the context can run this path; otherwise chunks keep their own buffers
+    static bool isSupported();
+
+    void setMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<Texture> texture);
+    bool hasMaterial() const { return shader && texture; }
+
+    // Copies a mesh into the arena, growing it when needed. When `staged` holds the same
+    // mesh in the upload ring (vertices, then indices at an aligned offset) the copy is
+    // done on the GPU from there instead of from the vectors.
+    std::shared_ptr<TerrainMesh> upload(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                        const std::shared_ptr<StagedUpload> &staged = nullptr);
+
+    // Null when the context has no GL 4.4 persistent mapping
+    std::shared_ptr<UploadRing> getUploadRing() const { return uploadRing; }
+
+    // Queues indices [firstIndex, firstIndex + indexCount) of a mesh, relative to the mesh
+    void submit(const TerrainMesh &mesh, const glm::vec3 &origin, std::size_t firstIndex, std::size_t indexCount);
+
+    void beginFrame();
+    // View and projection come from the Camera uniform block
+    void draw();
+
+    std::size_t getSubmittedCount() const { return commands.size(); }
+    std::size_t getVertexArenaUsed() const { return vertexAllocator.getUsed(); }
+    std::size_t getVertexArenaCapacity() const { return vertexAllocator.getCapacity(); }
+
+private:
+    friend struct TerrainMesh;
+
+    // Layout fixed by the GL spec for indirect indexed draws
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    GLuint vao = 0;
+    GLuint vertexArena = 0;
+    GLuint indexArena = 0;
+    GLuint drawIndexBuffer = 0; // 0, 1, 2, ... read once per draw through baseInstance
+    GLuint originBuffer = 0;    // SSBO of vec4 chunk origins
+    GLuint commandBuffer = 0;
+
+    RangeAllocator vertexAllocator;
+    RangeAllocator indexAllocator;
+    std::size_t drawIndexCapacity = 0;
+
+    std::vector<DrawCommand> commands;
+    std::vector<glm::vec4> origins;
+
+    std::shared_ptr<Shader> shader;
+    std::shared_ptr<Texture> texture;
+    std::shared_ptr<UploadRing> uploadRing;
+
+    void release(const TerrainMesh &mesh);
+    // Arena use and size in the "mesh.gpu_*" gauges
+    void updateMemoryMetrics();
+    void growVertexArena(std::size_t minimumCapacity);
+    void growIndexArena(std::size_t minimumCapacity);
+    void ensureDrawIndices(std::size_t count);
+    void bindVertexLayout();
+};
+
+#endif // TERRAIN_RENDERER_H
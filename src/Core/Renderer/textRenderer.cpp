@@ -0,0 +1,269 @@
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include "textRenderer.h"
+
+namespace
+{
+    // Next code point of a UTF-8 string; malformed bytes come out as U+FFFD one at a time
+    std::uint32_t decodeUtf8(std::string_view text, std::size_t &i)
+    {
+        unsigned char lead = static_cast<unsigned char>(text[i++]);
+        if (lead < 0x80)
+            return lead;
+        int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+        if (extra < 0 || i + extra > text.size())
+            return 0xFFFD;
+        std::uint32_t codePoint = lead & (0x3F >> extra);
+        for (int k = 0; k < extra; k++)
+        {
+            unsigned char next = static_cast<unsigned char>(text[i]);
+            if ((next & 0xC0) != 0x80)
+                return 0xFFFD;
+            codePoint = (codePoint << 6) | (next & 0x3F);
+            i++;
+        }
+        return codePoint;
+    }
+}
+
+TextRenderer::TextRenderer()
+{
+    if (FT_Init_FreeType(&library))
+    {
+        std::cerr << "Failed to initialize FreeType" << std::endl;
+        library = nullptr;
+    }
+}
+
+TextRenderer::~TextRenderer()
+{
+    closeFace();
+    if (library)
+        FT_Done_FreeType(library);
+}
+
+void TextRenderer::closeFace()
+{
+    if (face)
+        FT_Done_Face(face);
+    face = nullptr;
+}
+
+bool TextRenderer::loadFont(const std::string &path, int pixelSize)
+{
+    closeFace();
+    resetAtlas();
+    if (!library)
+        return false;
+    if (FT_New_Face(library, path.c_str(), 0, &face))
+    {
+        face = nullptr;
+        return false;
+    }
+    FT_Set_Pixel_Sizes(face, 0, pixelSize);
+    lineHeight = static_cast<int>(face->size->metrics.height >> 6);
+    ascender = static_cast<int>(face->size->metrics.ascender >> 6);
+
+    if (!atlas)
+        createAtlas();
+    return true;
+}
+
+void TextRenderer::createAtlas()
+{
+    atlas = std::make_shared<Texture>(atlasSize, atlasSize, 4, false);
+    // Transparent to start with, so sampling past a glyph's edge never shows garbage
+    std::vector<unsigned char> clear(atlasSize * atlasSize * 4, 0);
+    atlas->updateRegion(0, 0, atlasSize, atlasSize, clear.data());
+}
+
+void TextRenderer::resetAtlas()
+{
+    // Old texels stay in the texture; nothing points at them anymore
+    shelves.clear();
+    nextShelfY = 0;
+    resetPending = false;
+    glyphs.clear();
+    layouts.clear();
+    atlasGeneration++;
+}
+
+bool TextRenderer::packGlyph(int width, int height, glm::ivec2 &origin)
+{
+    // One texel of padding so filtering never bleeds between neighbours
+    int paddedWidth = width + 1, paddedHeight = height + 1;
+    Shelf *best = nullptr;
+    for (auto &shelf : shelves)
+    {
+        if (shelf.height >= paddedHeight && shelf.cursor + paddedWidth <= atlasSize &&
+            (!best || shelf.height < best->height))
+            best = &shelf;
+    }
+    if (!best)
+    {
+        if (nextShelfY + paddedHeight > atlasSize || paddedWidth > atlasSize)
+            return false;
+        shelves.push_back({nextShelfY, paddedHeight, 0});
+        nextShelfY += paddedHeight;
+        best = &shelves.back();
+    }
+    origin = glm::ivec2(best->cursor, best->y);
+    best->cursor += paddedWidth;
+    return true;
+}
+
+const TextRenderer::Glyph *TextRenderer::getGlyph(std::uint32_t codePoint)
+{
+    auto found = glyphs.find(codePoint);
+    if (found != glyphs.end())
+        return &found->second;
+    if (!face || FT_Load_Char(face, codePoint, FT_LOAD_RENDER))
+        return nullptr;
+
+    const FT_GlyphSlot slot = face->glyph;
+    const FT_Bitmap &bitmap = slot->bitmap;
+    Glyph glyph{};
+    glyph.size = glm::ivec2(bitmap.width, bitmap.rows);
+    glyph.bearing = glm::ivec2(slot->bitmap_left, slot->bitmap_top);
+    glyph.advance = static_cast<int>(slot->advance.x >> 6);
+    glyph.index = FT_Get_Char_Index(face, codePoint);
+
+    // Spaces and the like have nothing to upload
+    if (glyph.size.x > 0 && glyph.size.y > 0)
+    {
+        glm::ivec2 origin;
+        // Nothing to gain from a reset when it couldn't fit in an empty atlas either
+        if (resetPending || glyph.size.x + 1 > MAX_ATLAS_SIZE || glyph.size.y + 1 > MAX_ATLAS_SIZE)
+            return nullptr;
+        if (!packGlyph(glyph.size.x, glyph.size.y, origin))
+        {
+            // Full: start over with only what's drawn from now on, in a bigger atlas
+            // while that's allowed so large fonts don't keep evicting each other.
+            // Text queued earlier this frame keeps the old texture alive through its
+            // quads, but at the maximum size the same texture would be overwritten
+            // under it, so that reset waits for the next frame and the glyph is
+            // skipped until then.
+            if (atlasSize >= MAX_ATLAS_SIZE)
+            {
+                resetPending = true;
+                return nullptr;
+            }
+            atlasSize *= 2;
+            createAtlas();
+            resetAtlas();
+            if (!packGlyph(glyph.size.x, glyph.size.y, origin))
+                return nullptr;
+        }
+
+        // Coverage goes into alpha over white, so the 2D shader's vertex color tints it
+        std::vector<unsigned char> pixels(glyph.size.x * glyph.size.y * 4, 255);
+        for (int y = 0; y < glyph.size.y; y++)
+        {
+            const unsigned char *row = bitmap.pitch >= 0 ? bitmap.buffer + y * bitmap.pitch
+                                                         : bitmap.buffer + (glyph.size.y - 1 - y) * -bitmap.pitch;
+            for (int x = 0; x < glyph.size.x; x++)
+                pixels[(y * glyph.size.x + x) * 4 + 3] = row[x];
+        }
+        atlas->updateRegion(origin.x, origin.y, glyph.size.x, glyph.size.y, pixels.data());
+
+        float scale = 1.0f / atlasSize;
+        glyph.uv0 = glm::vec2(origin.x, origin.y + glyph.size.y) * scale;
+        glyph.uv1 = glm::vec2(origin.x + glyph.size.x, origin.y) * scale;
+    }
+    return &glyphs.emplace(codePoint, glyph).first->second;
+}
+
+const TextRenderer::Layout &TextRenderer::getLayout(std::string_view text)
+{
+    std::size_t hash = std::hash<std::string_view>{}(text);
+    auto found = layouts.find(hash);
+    if (found != layouts.end() && found->second.text == text)
+    {
+        found->second.lastUsed = frame;
+        return found->second;
+    }
+
+    Layout layout;
+    layout.text = std::string(text);
+    layout.lastUsed = frame;
+    // A glyph that fills the atlas resets it, which drops the glyphs laid out so far;
+    // the next pass starts from the fresh atlas. Growing can reset it more than once.
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        int generation = atlasGeneration;
+        layout.quads.clear();
+        layout.size = glm::vec2(0.0f);
+
+        int penX = 0, baseline = ascender;
+        unsigned int previous = 0;
+        for (std::size_t i = 0; i < text.size();)
+        {
+            std::uint32_t codePoint = decodeUtf8(text, i);
+            if (codePoint == '\n')
+            {
+                penX = 0;
+                baseline += lineHeight;
+                previous = 0;
+                continue;
+            }
+            const Glyph *glyph = getGlyph(codePoint);
+            if (!glyph)
+                continue;
+            if (previous && glyph->index && FT_HAS_KERNING(face))
+            {
+                FT_Vector kerning;
+                FT_Get_Kerning(face, previous, glyph->index, FT_KERNING_DEFAULT, &kerning);
+                penX += static_cast<int>(kerning.x >> 6);
+            }
+            if (glyph->size.x > 0 && glyph->size.y > 0)
+            {
+                layout.quads.push_back({glm::vec2(penX + glyph->bearing.x, baseline - glyph->bearing.y),
+                                        glm::vec2(glyph->size), glyph->uv0, glyph->uv1});
+            }
+            penX += glyph->advance;
+            previous = glyph->index;
+            layout.size.x = std::max(layout.size.x, static_cast<float>(penX));
+        }
+        layout.size.y = static_cast<float>(baseline - ascender + lineHeight);
+        if (atlasGeneration == generation)
+            break;
+    }
+
+    auto &entry = layouts[hash];
+    entry = std::move(layout);
+    return entry;
+}
+
+void TextRenderer::beginFrame()
+{
+    frame++;
+    // Drops the layouts built while it was pending too, so none stay missing glyphs
+    if (resetPending)
+        resetAtlas();
+    if (frame % LAYOUT_LIFETIME != 0)
+        return;
+    std::erase_if(layouts, [this](const auto &entry)
+                  { return frame - entry.second.lastUsed > LAYOUT_LIFETIME; });
+}
+
+void TextRenderer::drawText(Renderer2D &renderer, std::string_view text, const glm::vec2 &position, const glm::vec4 &color)
+{
+    if (!face || text.empty())
+        return;
+    const Layout &layout = getLayout(text);
+    // Whole pixels keep the nearest-filtered glyphs crisp
+    glm::vec2 origin = glm::floor(position);
+    for (const auto &quad : layout.quads)
+        renderer.drawQuad(origin + quad.offset, quad.size, atlas, quad.uv0, quad.uv1, color);
+}
+
+glm::vec2 TextRenderer::measureText(std::string_view text)
+{
+    if (!face || text.empty())
+        return glm::vec2(0.0f);
+    return getLayout(text).size;
+}
@@ -0,0 +1,106 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "renderer2D.h"
+#include "../Rendering/texture.h"
+
+// Opaque FreeType handles, so only textRenderer.cpp needs the FreeType headers
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+// Screen text drawn through Renderer2D. Glyphs are rasterized the first time they're
+// used and shelf-packed into one atlas texture; laid-out strings are cached by content,
+// so text that doesn't change from frame to frame costs a hash lookup and its quads.
+// Layouts not drawn for a while are dropped, which keeps per-frame strings like an FPS
+// counter from piling up.
+class TextRenderer
+{
+public:
+    static const int ATLAS_SIZE = 512;      // Starting size; doubles when a font outgrows it
+    static const int MAX_ATLAS_SIZE = 2048;
+    static const std::uint64_t LAYOUT_LIFETIME = 120; // Frames an unused layout is kept
+
+    TextRenderer();
+    ~TextRenderer();
+
+    // Replaces the current font; false (and nothing drawn) when it can't be loaded
+    bool loadFont(const std::string &path, int pixelSize);
+    bool hasFont() const { return face != nullptr; }
+    int getLineHeight() const { return lineHeight; }
+
+    // Ages the layout cache and applies a deferred atlas reset; call once per frame
+    // before drawing
+    void beginFrame();
+    // `position` is the top-left corner of the first line; '\n' starts a new line
+    void drawText(Renderer2D &renderer, std::string_view text, const glm::vec2 &position,
+                  const glm::vec4 &color = glm::vec4(1.0f));
+    glm::vec2 measureText(std::string_view text);
+
+    std::size_t getCachedLayoutCount() const { return layouts.size(); }
+    std::size_t getCachedGlyphCount() const { return glyphs.size(); }
+
+private:
+    struct Glyph
+    {
+        glm::vec2 uv0, uv1;  // Bottom-left and top-right in the atlas
+        glm::ivec2 size;     // Bitmap size in pixels
+        glm::ivec2 bearing;  // From the pen position to the bitmap's top-left, y up
+        int advance;
+        unsigned int index;  // FreeType glyph index, for kerning
+    };
+
+    struct GlyphQuad
+    {
+        glm::vec2 offset; // From the text's top-left corner, y down
+        glm::vec2 size;
+        glm::vec2 uv0, uv1;
+    };
+
+    struct Layout
+    {
+        std::string text; // Guards against hash collisions
+        std::vector<GlyphQuad> quads;
+        glm::vec2 size{0.0f};
+        std::uint64_t lastUsed = 0;
+    };
+
+    // One row of the atlas; glyphs no taller than it are packed left to right
+    struct Shelf
+    {
+        int y;
+        int height;
+        int cursor;
+    };
+
+    FT_LibraryRec_ *library = nullptr;
+    FT_FaceRec_ *face = nullptr;
+    int lineHeight = 0;
+    int ascender = 0;
+
+    std::shared_ptr<Texture> atlas;
+    int atlasSize = ATLAS_SIZE;
+    std::vector<Shelf> shelves;
+    int nextShelfY = 0;
+    int atlasGeneration = 0; // Bumped whenever the atlas starts over
+    bool resetPending = false; // Full at the maximum size; starts over next frame
+    std::unordered_map<std::uint32_t, Glyph> glyphs; // By code point
+
+    std::unordered_map<std::size_t, Layout> layouts; // By hash of the text
+    std::uint64_t frame = 0;
+
+    const Glyph *getGlyph(std::uint32_t codePoint);
+    bool packGlyph(int width, int height, glm::ivec2 &origin);
+    void createAtlas();
+    void resetAtlas();
+    const Layout &getLayout(std::string_view text);
+    void closeFace();
+};
+
+#endif // TEXT_RENDERER_H
@@ -0,0 +1,184 @@
+#include <stdexcept>
+#include "uploadRing.h"
+
+StagedUpload::~StagedUpload()
+{
+    if (auto owner = ring.lock())
+        owner->setState(*region, UploadRegion::State::ABANDONED);
+}
+
+void StagedUpload::finishWriting()
+{
+    if (auto owner = ring.lock())
+        owner->setState(*region, UploadRegion::State::PENDING);
+}
+
+UploadRing::UploadRing(std::size_t capacity) : capacity(capacity)
+{
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, capacity, nullptr, flags);
+    mapped = static_cast<unsigned char *>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, capacity, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (!mapped)
+    {
+        glDeleteBuffers(1, &buffer);
+        throw std::runtime_error("Failed to map upload ring");
+    }
+}
+
+UploadRing::~UploadRing()
+{
+    for (auto &fence : fences)
+        glDeleteSync(fence.sync);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+}
+
+bool UploadRing::isSupported()
+{
+    return GLAD_GL_VERSION_4_4 != 0;
+}
+
+std::shared_ptr<StagedUpload> UploadRing::reserve(std::size_t bytes)
+{
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (bytes == 0 || bytes > capacity)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t offset;
+    while (!tryPlace(bytes, offset))
+    {
+        // Out of room: evict the oldest upload nobody has claimed yet.
+        // Its chunk still has the mesh on the CPU and falls back to a direct upload.
+        if (live.empty() || live.front()->state != UploadRegion::State::PENDING)
+            return nullptr;
+        live.front()->state = UploadRegion::State::ABANDONED;
+        releaseFinished();
+    }
+
+    auto region = std::make_shared<UploadRegion>();
+    region->offset = offset;
+    region->size = bytes;
+    live.push_back(region);
+    used += bytes;
+    head = offset + bytes;
+    return std::make_shared<StagedUpload>(weak_from_this(), region, mapped + offset);
+}
+
+bool UploadRing::tryPlace(std::size_t bytes, std::size_t &offset)
+{
+    if (live.empty())
+    {
+        head = 0;
+        offset = 0;
+        return bytes <= capacity;
+    }
+
+    std::size_t tail = live.front()->offset;
+    if (used == capacity)
+        return false;
+    if (head >= tail)
+    {
+        if (capacity - head >= bytes)
+        {
+            offset = head;
+            return true;
+        }
+        if (tail >= bytes)
+        {
+            // Pad out the end so the reservation starts at 0 in one piece
+            auto padding = std::make_shared<UploadRegion>();
+            padding->offset = head;
+            padding->size = capacity - head;
+            padding->state = UploadRegion::State::ABANDONED;
+            live.push_back(padding);
+            used += padding->size;
+            offset = 0;
+            return true;
+        }
+        return false;
+    }
+    if (tail - head >= bytes)
+    {
+        offset = head;
+        return true;
+    }
+    return false;
+}
+
+bool UploadRing::consume(StagedUpload &upload)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (upload.region->state != UploadRegion::State::PENDING)
+        return false;
+    upload.region->state = UploadRegion::State::COPYING;
+    upload.region->frame = currentFrame;
+    copiedThisFrame = true;
+    return true;
+}
+
+void UploadRing::setState(UploadRegion &region, UploadRegion::State state)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // A copy in flight keeps its space until the fence says the GPU is done with it
+    if (region.state == UploadRegion::State::COPYING || region.state == UploadRegion::State::ABANDONED)
+        return;
+    region.state = state;
+    releaseFinished();
+}
+
+void UploadRing::beginFrame()
+{
+    uint64_t completed = 0;
+    while (!fences.empty())
+    {
+        GLenum status = glClientWaitSync(fences.front().sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        completed = fences.front().frame;
+        glDeleteSync(fences.front().sync);
+        fences.pop_front();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (completed > completedFrame)
+        completedFrame = completed;
+    releaseFinished();
+}
+
+void UploadRing::endFrame()
+{
+    if (copiedThisFrame)
+    {
+        fences.push_back({currentFrame, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+        copiedThisFrame = false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    currentFrame++;
+}
+
+// Caller holds the mutex. Space only comes back in ring order.
+void UploadRing::releaseFinished()
+{
+    while (!live.empty())
+    {
+        const auto &front = live.front();
+        bool finished = front->state == UploadRegion::State::ABANDONED ||
+                        (front->state == UploadRegion::State::COPYING && front->frame <= completedFrame);
+        if (!finished)
+            break;
+        used -= front->size;
+        live.pop_front();
+    }
+}
+
+std::size_t UploadRing::getUsed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
@@ -0,0 +1,116 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+class UploadRing;
+
+// Bookkeeping for one stretch of the ring; guarded by the ring's mutex
+struct UploadRegion
+{
+    enum class State
+    {
+        WRITING,  // Being filled; must not be evicted
+        PENDING,  // Filled and waiting for the render thread
+        COPYING,  // A GPU copy was issued in `frame`
+        ABANDONED // Never going to be copied
+    };
+
+    std::size_t offset = 0;
+    std::size_t size = 0;
+    State state = State::WRITING;
+    uint64_t frame = 0;
+};
+
+// Space reserved in the ring. The reserving thread fills getData() and calls
+// finishWriting(); the render thread later copies it into its destination with
+// UploadRing::consume. Dropping the handle before that gives the space back.
+class StagedUpload
+{
+public:
+    StagedUpload(std::weak_ptr<UploadRing> ring, std::shared_ptr<UploadRegion> region, unsigned char *data)
+        : ring(ring), region(region), data(data) {}
+    ~StagedUpload();
+
+    StagedUpload(const StagedUpload &) = delete;
+    StagedUpload &operator=(const StagedUpload &) = delete;
+
+    void finishWriting();
+
+    unsigned char *getData() const { return data; }
+    std::size_t getOffset() const { return region->offset; }
+    std::size_t getSize() const { return region->size; }
+
+private:
+    friend class UploadRing;
+
+    std::weak_ptr<UploadRing> ring;
+    std::shared_ptr<UploadRegion> region;
+    unsigned char *data;
+};
+
+// Staging buffer for streaming uploads, created with glBufferStorage and mapped
+// persistently and coherently. Any thread may reserve() space and write to it
+// directly. Only the render thread issues GL calls: copies out of the ring, a
+// fence at the end of every frame that copied something, and polling those fences
+// to learn when space can be reused. Requires GL 4.4.
+class UploadRing : public std::enable_shared_from_this<UploadRing>
+{
+public:
+    static const std::size_t ALIGNMENT = 16;
+
+    explicit UploadRing(std::size_t capacity);
+    ~UploadRing();
+
+    static bool isSupported();
+
+    // Thread safe. Returns null when the ring has no room; the caller uploads the old way.
+    std::shared_ptr<StagedUpload> reserve(std::size_t bytes);
+
+    // Render thread: claims a staged upload for a copy it is about to issue this frame.
+    // False when the upload was evicted or never finished; the data must come from elsewhere.
+    bool consume(StagedUpload &upload);
+
+    // Render thread, once per frame on either side of the copies
+    void beginFrame();
+    void endFrame();
+
+    GLuint getBuffer() const { return buffer; }
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getUsed() const;
+
+private:
+    friend class StagedUpload;
+
+    struct FrameFence
+    {
+        uint64_t frame;
+        GLsync sync;
+    };
+
+    GLuint buffer = 0;
+    unsigned char *mapped = nullptr;
+    std::size_t capacity;
+
+    mutable std::mutex mutex;
+    std::deque<std::shared_ptr<UploadRegion>> live; // In ring order, oldest first
+    std::size_t head = 0;                           // Where the next reservation starts
+    std::size_t used = 0;                           // Bytes held by live regions, padding included
+    uint64_t completedFrame = 0;                    // Newest frame whose copies the GPU has finished
+
+    // Render thread only
+    std::deque<FrameFence> fences;
+    uint64_t currentFrame = 1;
+    bool copiedThisFrame = false;
+
+    void setState(UploadRegion &region, UploadRegion::State state);
+    void releaseFinished();
+    bool tryPlace(std::size_t bytes, std::size_t &offset);
+};
+
+#endif // UPLOAD_RING_H
@@ -0,0 +1,345 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include "renderStats.h"
+
+// Client-side mirror of the GL state the renderer touches: bound program, vertex
+// array, 2D texture per unit, capabilities, blend function and depth mask. Calls
+// that would not change anything are dropped, and nothing is ever read back from
+// the driver. Everything that binds these must go through here, or reset() must
+// be called afterwards.
+//
+// Also wraps resource creation and updates in Direct State Access (GL 4.5) with
+// a bind-to-edit fallback for older contexts.
+class GLState
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 32;
+
+    static GLState &getInstance()
+    {
+        static GLState instance;
+        return instance;
+    }
+
+    // Forgets everything; the next call of each kind always reaches the driver.
+    // Needed after a new context or third-party code that binds behind our back.
+    void reset()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        textures.fill(UNKNOWN);
+        capabilities.clear();
+        blendSrc = UNKNOWN;
+        blendDst = UNKNOWN;
+        depthMask = -1;
+    }
+
+    void useProgram(GLuint id)
+    {
+        if (program == id)
+            return;
+        glUseProgram(id);
+        program = id;
+        counters.programBinds++;
+    }
+
+    void bindVertexArray(GLuint id)
+    {
+        if (vertexArray == id)
+            return;
+        glBindVertexArray(id);
+        vertexArray = id;
+    }
+
+    void bindTexture(int unit, GLuint id)
+    {
+        if (unit < 0 || unit >= MAX_TEXTURE_UNITS || textures[unit] == id)
+            return;
+        if (hasDSA())
+        {
+            glBindTextureUnit(unit, id);
+        }
+        else
+        {
+            setActiveUnit(unit);
+            glBindTexture(GL_TEXTURE_2D, id);
+        }
+        textures[unit] = id;
+        counters.textureBinds++;
+    }
+
+    void setCapability(GLenum capability, bool enabled)
+    {
+        auto it = capabilities.find(capability);
+        if (it != capabilities.end() && it->second == enabled)
+            return;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+        capabilities[capability] = enabled;
+    }
+
+    void setBlendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        if (blendSrc == sfactor && blendDst == dfactor)
+            return;
+        glBlendFunc(sfactor, dfactor);
+        blendSrc = sfactor;
+        blendDst = dfactor;
+    }
+
+    void setDepthMask(bool enabled)
+    {
+        if (depthMask == static_cast<int>(enabled))
+            return;
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        depthMask = enabled;
+    }
+
+    // Running totals; the Renderer takes and clears them once per frame
+    RenderCounters &getCounters() { return counters; }
+    void countDraw(std::uint64_t indexCount, std::uint64_t instances = 1)
+    {
+        counters.drawCalls++;
+        counters.triangles += indexCount / 3 * instances;
+    }
+
+    GLuint getProgram() const { return program; }
+    GLuint getVertexArray() const { return vertexArray; }
+
+    // Unit the texture is bound to, or -1
+    int findTexture(GLuint id) const
+    {
+        for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+        {
+            if (textures[unit] == id)
+                return unit;
+        }
+        return -1;
+    }
+
+    // Call before deleting an object, so a recycled name isn't taken as already bound
+    void forgetProgram(GLuint id)
+    {
+        if (program == id)
+            program = UNKNOWN;
+    }
+    void forgetVertexArray(GLuint id)
+    {
+        if (vertexArray == id)
+            vertexArray = UNKNOWN;
+    }
+    void forgetTexture(GLuint id)
+    {
+        for (auto &bound : textures)
+        {
+            if (bound == id)
+                bound = UNKNOWN;
+        }
+    }
+
+    static bool hasDSA() { return GLAD_GL_VERSION_4_5 != 0; }
+
+    // Buffers are edited through GL_COPY_WRITE_BUFFER when DSA is missing,
+    // which is not VAO state and so never disturbs an element array binding
+    static GLuint createBuffer()
+    {
+        GLuint id;
+        if (hasDSA())
+            glCreateBuffers(1, &id);
+        else
+            glGenBuffers(1, &id);
+        return id;
+    }
+
+    static void bufferData(GLuint buffer, GLsizeiptr size, const void *data, GLenum usage)
+    {
+        if (data)
+            getInstance().counters.bufferBytes += size;
+        if (hasDSA())
+        {
+            glNamedBufferData(buffer, size, data, usage);
+            return;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    static void bufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void *data)
+    {
+        getInstance().counters.bufferBytes += size;
+        if (hasDSA())
+        {
+            glNamedBufferSubData(buffer, offset, size, data);
+            return;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    static void copyBufferSubData(GLuint source, GLuint destination, GLintptr sourceOffset, GLintptr destinationOffset, GLsizeiptr size)
+    {
+        getInstance().counters.bufferBytes += size;
+        if (hasDSA())
+        {
+            glCopyNamedBufferSubData(source, destination, sourceOffset, destinationOffset, size);
+            return;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, source);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    static GLuint createVertexArray()
+    {
+        GLuint id;
+        if (hasDSA())
+            glCreateVertexArrays(1, &id);
+        else
+            glGenVertexArrays(1, &id);
+        return id;
+    }
+
+    // Feeds attribute `index` from `buffer`; integer attributes skip float conversion.
+    // Each attribute gets its own binding point, numbered like the attribute.
+    void vertexAttrib(GLuint vao, GLuint index, GLuint buffer, GLint size, GLenum type, GLsizei stride,
+                      std::size_t offset, bool integer = false, GLuint divisor = 0)
+    {
+        if (hasDSA())
+        {
+            glVertexArrayVertexBuffer(vao, index, buffer, 0, stride);
+            if (integer)
+                glVertexArrayAttribIFormat(vao, index, size, type, static_cast<GLuint>(offset));
+            else
+                glVertexArrayAttribFormat(vao, index, size, type, GL_FALSE, static_cast<GLuint>(offset));
+            glVertexArrayAttribBinding(vao, index, index);
+            glVertexArrayBindingDivisor(vao, index, divisor);
+            glEnableVertexArrayAttrib(vao, index);
+            return;
+        }
+        bindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (integer)
+            glVertexAttribIPointer(index, size, type, stride, reinterpret_cast<const void *>(offset));
+        else
+            glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<const void *>(offset));
+        glVertexAttribDivisor(index, divisor);
+        glEnableVertexAttribArray(index);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void elementBuffer(GLuint vao, GLuint buffer)
+    {
+        if (hasDSA())
+        {
+            glVertexArrayElementBuffer(vao, buffer);
+            return;
+        }
+        bindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    }
+
+    static GLuint createTexture2D()
+    {
+        GLuint id;
+        if (hasDSA())
+            glCreateTextures(GL_TEXTURE_2D, 1, &id);
+        else
+            glGenTextures(1, &id);
+        return id;
+    }
+
+    void textureParameter(GLuint texture, GLenum name, GLint value)
+    {
+        if (hasDSA())
+        {
+            glTextureParameteri(texture, name, value);
+            return;
+        }
+        bindForEdit(texture);
+        glTexParameteri(GL_TEXTURE_2D, name, value);
+    }
+
+    // Uploads 8-bit RGB or RGBA pixels and builds the full mip chain. Null pixels only
+    // allocate level 0, for textures filled in later with textureSubImage2D.
+    void textureImage2D(GLuint texture, int width, int height, int channels, const void *pixels)
+    {
+        GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+        if (hasDSA())
+        {
+            int levels = 1;
+            while (pixels && ((width >> levels) > 0 || (height >> levels) > 0))
+                levels++;
+            glTextureStorage2D(texture, levels, channels == 4 ? GL_RGBA8 : GL_RGB8, width, height);
+            if (!pixels)
+                return;
+            glTextureSubImage2D(texture, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+            glGenerateTextureMipmap(texture);
+            return;
+        }
+        bindForEdit(texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+        if (pixels)
+            glGenerateMipmap(GL_TEXTURE_2D);
+        else
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+
+    // Overwrites a rectangle of level 0; mipmaps are left alone
+    void textureSubImage2D(GLuint texture, int x, int y, int width, int height, int channels, const void *pixels)
+    {
+        GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+        if (hasDSA())
+        {
+            glTextureSubImage2D(texture, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+            return;
+        }
+        bindForEdit(texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    }
+
+private:
+    // The glTex* calls act on the active unit, which bindTexture leaves alone when the
+    // texture is already bound there, so unit 0 is selected here either way
+    void bindForEdit(GLuint texture)
+    {
+        setActiveUnit(0);
+        bindTexture(0, texture);
+    }
+
+    // Never a valid name, so the first bind after reset() always goes through
+    static constexpr GLuint UNKNOWN = static_cast<GLuint>(-1);
+
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint activeUnit = UNKNOWN;
+    std::array<GLuint, MAX_TEXTURE_UNITS> textures;
+    std::unordered_map<GLenum, bool> capabilities;
+    GLenum blendSrc = UNKNOWN;
+    GLenum blendDst = UNKNOWN;
+    int depthMask = -1;
+    RenderCounters counters;
+
+    GLState() { textures.fill(UNKNOWN); }
+
+    void setActiveUnit(int unit)
+    {
+        if (activeUnit == static_cast<GLuint>(unit))
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+};
+
+#endif // GL_STATE_H
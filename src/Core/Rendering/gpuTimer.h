@@ -0,0 +1,102 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+#include <array>
+
+// GL_TIME_ELAPSED query around a stretch of GL calls, read back without ever waiting
+// on the driver. Each frame uses the next of a few queries and only collects those
+// whose results are already available; if the GPU is so far behind that the next
+// query is still in flight, that frame simply isn't timed. Queries can't nest, so
+// only one timer may be running at a time.
+class GpuTimer
+{
+public:
+    static const int QUERY_COUNT = 3;
+
+    GpuTimer() = default;
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    ~GpuTimer() { release(); }
+
+    // Deletes the queries; call before the context goes away. The timer starts over if used again.
+    void release()
+    {
+        if (created)
+            glDeleteQueries(QUERY_COUNT, queries.data());
+        created = false;
+        running = false;
+        pending.fill(false);
+    }
+
+    // Core since GL 3.3, which Mesa's software rasterizers provide too
+    static bool isSupported() { return GLAD_GL_VERSION_3_3 != 0; }
+
+    void begin()
+    {
+        if (!isSupported())
+            return;
+        if (!created)
+        {
+            glGenQueries(QUERY_COUNT, queries.data());
+            created = true;
+        }
+        collect();
+        running = !pending[next];
+        if (running)
+            glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+    }
+
+    void end()
+    {
+        if (!running)
+            return;
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % QUERY_COUNT;
+        running = false;
+    }
+
+    // Most recent result, or -1 before the first one arrives
+    double getMs()
+    {
+        if (created)
+            collect();
+        return lastMs;
+    }
+
+private:
+    static constexpr GLuint64 MAX_PLAUSIBLE_NS = 1000000000;
+
+    std::array<GLuint, QUERY_COUNT> queries{};
+    std::array<bool, QUERY_COUNT> pending{};
+    int next = 0;
+    bool created = false;
+    bool running = false;
+    double lastMs = -1.0;
+
+    // Oldest first, so the last result read is the newest one
+    void collect()
+    {
+        for (int i = 0; i < QUERY_COUNT; i++)
+        {
+            int index = (next + i) % QUERY_COUNT;
+            if (!pending[index])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break; // Later ones can't be done either
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &nanoseconds);
+            pending[index] = false;
+            // llvmpipe reports a huge value for the first timed draw of a context;
+            // no real pass takes a whole second
+            if (nanoseconds < MAX_PLAUSIBLE_NS)
+                lastMs = nanoseconds / 1.0e6;
+        }
+    }
+};
+
+#endif // GPU_TIMER_H
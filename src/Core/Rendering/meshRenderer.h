@@ -14,6 +14,7 @@
 #include "../Util/vertex.h"
 #include "../Renderer/renderer.h"
 #include <memory>
+#include <unordered_map>
 
 enum MatrixType
 {
@@ -53,7 +54,7 @@ public:
                 throw std::runtime_error("Shader or/and Transform must be valid");
             return;
         }
-        vertexBuffer = std::make_shared<UV_VertexBuffer>(mesh->vertices, mesh->indices);
+        vertexBuffer = acquireVertexBuffer(mesh);
         viewMatrix = glm::mat4(1.0f);
         projectionMatrix = glm::mat4(1.0f);
         isInitialized = true;
@@ -95,7 +96,7 @@ public:
         this->texture = texture;
         this->transform = transform;
         if (mesh)
-            this->vertexBuffer = std::make_shared<UV_VertexBuffer>(mesh->vertices, mesh->indices);
+            this->vertexBuffer = acquireVertexBuffer(mesh);
         isInitialized = true;
         return true;
     }
@@ -106,11 +107,12 @@ public:
 
     ~UV_MeshRenderer() = default;
 
-    void queueToRender(std::shared_ptr<Renderer> renderer)
+    // indexCount = 0 draws the whole mesh
+    void queueToRender(std::shared_ptr<Renderer> renderer, unsigned int firstIndex = 0, unsigned int indexCount = 0)
     {
         if (!isInitialized || !vertexBuffer || !mesh)
             return;
-        renderer->renderMesh(vertexBuffer, texture, transform);
+        renderer->renderMesh(vertexBuffer, texture, transform, firstIndex, indexCount, shader);
     }
 
     void render()
@@ -127,6 +129,7 @@ public:
 
         vertexBuffer->bind();
         glDrawElements(GL_TRIANGLES, mesh->indices.size(), GL_UNSIGNED_INT, 0);
+        GLState::getInstance().countDraw(mesh->indices.size());
         vertexBuffer->unbind();
 
         texture->unbind(); // DON'T forget this
@@ -196,15 +199,19 @@ public:
     {
         if (isInitialized)
         {
+            auto oldMesh = mesh;
             mesh = newMesh;
-            if (vertexBuffer)
+            // Rewriting a buffer in place is only safe when nobody else draws from it
+            if (vertexBuffer && vertexBuffer.use_count() == 1)
             {
                 vertexBuffer->updateVertices(newMesh->vertices);
                 vertexBuffer->updateIndices(newMesh->indices);
+                forgetVertexBuffer(oldMesh);
+                getSharedBuffers()[newMesh.get()] = {newMesh, vertexBuffer};
             }
             else
             {
-                vertexBuffer = std::make_shared<UV_VertexBuffer>(newMesh->vertices, newMesh->indices);
+                vertexBuffer = acquireVertexBuffer(newMesh);
             }
         }
     }
@@ -217,6 +224,52 @@ public:
     std::shared_ptr<UV_VertexBuffer> getVertexBuffer() { return vertexBuffer; }
 
 private:
+    struct SharedBuffer
+    {
+        std::weak_ptr<UV_Mesh> mesh;
+        std::weak_ptr<UV_VertexBuffer> buffer;
+    };
+
+    // Render thread only, like every GL object
+    static std::unordered_map<const UV_Mesh *, SharedBuffer> &getSharedBuffers()
+    {
+        static std::unordered_map<const UV_Mesh *, SharedBuffer> buffers;
+        return buffers;
+    }
+
+    // Renderers given the same mesh share one vertex buffer, which is what lets the
+    // Renderer draw all of them as instances of a single draw
+    static std::shared_ptr<UV_VertexBuffer> acquireVertexBuffer(const std::shared_ptr<UV_Mesh> &mesh)
+    {
+        auto &buffers = getSharedBuffers();
+        auto it = buffers.find(mesh.get());
+        // The address alone could belong to a mesh that has since been freed
+        if (it != buffers.end() && it->second.mesh.lock() == mesh)
+        {
+            if (auto buffer = it->second.buffer.lock())
+                return buffer;
+        }
+
+        // Drop entries whose buffers are gone once they pile up
+        static std::size_t nextSweep = 64;
+        if (buffers.size() >= nextSweep)
+        {
+            std::erase_if(buffers, [](const auto &entry)
+                          { return entry.second.buffer.expired(); });
+            nextSweep = buffers.size() * 2 + 64;
+        }
+
+        auto buffer = std::make_shared<UV_VertexBuffer>(mesh->vertices, mesh->indices);
+        buffers[mesh.get()] = {mesh, buffer};
+        return buffer;
+    }
+
+    static void forgetVertexBuffer(const std::shared_ptr<UV_Mesh> &mesh)
+    {
+        if (mesh)
+            getSharedBuffers().erase(mesh.get());
+    }
+
     glm::mat4 viewMatrix;
     glm::mat4 projectionMatrix;
 
@@ -0,0 +1,61 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <array>
+#include <cstdint>
+
+// What a frame asked of the driver, counted where the calls are made (mostly GLState).
+// Binds only count when they get past the state cache.
+struct RenderCounters
+{
+    std::uint64_t drawCalls = 0;
+    std::uint64_t triangles = 0;
+    std::uint64_t bufferBytes = 0; // Uploaded or copied into buffer objects
+    std::uint64_t textureBinds = 0;
+    std::uint64_t programBinds = 0;
+};
+
+// Parts of the frame timed on the GPU, in the order they're drawn
+enum RenderPass
+{
+    RENDER_PASS_HORIZON,
+    RENDER_PASS_TERRAIN,
+    RENDER_PASS_MESHES,
+    RENDER_PASS_UI,
+    RENDER_PASS_COUNT
+};
+
+inline const char *getRenderPassName(RenderPass pass)
+{
+    switch (pass)
+    {
+    case RENDER_PASS_HORIZON:
+        return "horizon";
+    case RENDER_PASS_TERRAIN:
+        return "terrain";
+    case RENDER_PASS_MESHES:
+        return "meshes";
+    case RENDER_PASS_UI:
+        return "UI";
+    default:
+        return "?";
+    }
+}
+
+// One finished frame. GPU times lag the counters by a frame or two, since they're
+// only read once the driver has them; -1 until a pass has been timed at all.
+struct RenderStats
+{
+    RenderCounters counters;
+    std::array<double, RENDER_PASS_COUNT> gpuMs{-1.0, -1.0, -1.0, -1.0};
+
+    double getGpuTotalMs() const
+    {
+        double total = 0.0;
+        for (double ms : gpuMs)
+            total += ms > 0.0 ? ms : 0.0;
+        return total;
+    }
+};
+
+#endif // RENDER_STATS_H
@@ -8,10 +8,19 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+
+#include "glState.h"
 
 class Shader
 {
 public:
+    // Binding point of the per-frame Camera uniform block, filled by the Renderer
+    static const GLuint CAMERA_BLOCK_BINDING = 0;
+    // Instanced shaders read their model matrix from a per-instance mat4 named aModel
+    // at this location (and the three after it), streamed by the Renderer
+    static const GLint INSTANCE_MODEL_LOCATION = 3;
+
     unsigned int ID;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
@@ -68,89 +77,129 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        cacheUniformLocations();
+        GLuint cameraBlock = glGetUniformBlockIndex(ID, "Camera");
+        if (cameraBlock != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, cameraBlock, CAMERA_BLOCK_BINDING);
+        instanced = glGetAttribLocation(ID, "aModel") == INSTANCE_MODEL_LOCATION;
 
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const
     {
-        glUseProgram(ID);
+        GLState::getInstance().useProgram(ID);
     }
     void unuse() const
     {
-        glUseProgram(0);
+        GLState::getInstance().useProgram(0);
     }
 
     void isActive() const
     {
-        GLint currentProgram;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
-        if (currentProgram != ID)
+        if (GLState::getInstance().getProgram() != ID)
         {
             std::cout << "Shader is not active!" << std::endl;
         }
     }
 
+    // Takes its model matrix per instance instead of from the "model" uniform
+    bool isInstanced() const { return instanced; }
+
+    // Resolved once after linking; -1 for names the program doesn't use, which glUniform ignores
+    GLint getUniformLocation(const std::string& name) const
+    {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(getUniformLocation(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(getUniformLocation(name), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(getUniformLocation(name), x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(getUniformLocation(name), x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(getUniformLocation(name), 1, &value[0]);
     }
     void setVec4(const std::string& name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(getUniformLocation(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+    bool instanced = false;
+
+    void cacheUniformLocations()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, &name[0]);
+            std::string uniform = name.substr(0, length);
+            // Members of uniform blocks report -1; they're set through the buffer
+            GLint location = glGetUniformLocation(ID, uniform.c_str());
+            if (location < 0)
+                continue;
+            uniformLocations[uniform] = location;
+            // Arrays are reported as "name[0]"; accept the bare name too
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+                uniformLocations[uniform.substr(0, uniform.size() - 3)] = location;
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
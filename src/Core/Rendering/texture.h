@@ -6,8 +6,8 @@
 #include <iostream>
 #include <string>
 #include <filesystem>
-#include <set>
 #include "shader.h"
+#include "glState.h"
 #include <memory>
 
 #define CRISP_TEXTURES true
@@ -20,20 +20,20 @@ public:
     // Constructor that loads a texture from a file
     Texture(const std::string &path, bool flip = false)
     {
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        auto &gl = GLState::getInstance();
+        textureID = GLState::createTexture2D();
 
         // Set the texture wrapping parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        gl.textureParameter(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        gl.textureParameter(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
         // Set texture filtering parameters based on pixelated flag
         if (CRISP_TEXTURES) {
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            gl.textureParameter(textureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            gl.textureParameter(textureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         } else {
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gl.textureParameter(textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            gl.textureParameter(textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         }
 
         // Load image, create texture and generate mipmaps
@@ -47,23 +47,12 @@ public:
         else if (ENABLE_FALLBACK_TEXTURE)
         {
             std::cerr << "Failed to load texture, using fallback: " << path << std::endl;
-
-            // Create a separate texture object for the fallback texture
-            unsigned int fallbackTextureID;
-            glGenTextures(1, &fallbackTextureID);
-            glBindTexture(GL_TEXTURE_2D, fallbackTextureID);
-
             data = stbi_load(FALLBACK_TEXTURE_PATH, &width, &height, &nrChannels, 0);
-
-            // Assign the fallback texture ID to this instance
-            textureID = fallbackTextureID;
         }
 
         if (data)
         {
-            GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+            gl.textureImage2D(textureID, width, height, nrChannels, data);
             buffer.assign(data, data + (width * height * nrChannels));
         }
         else
@@ -74,34 +63,48 @@ public:
         stbi_image_free(data);
     }
 
+    // Blank texture without mipmaps, filled in piece by piece with updateRegion
+    Texture(int width, int height, int channels, bool smooth)
+        : width(width), height(height), nrChannels(channels)
+    {
+        auto &gl = GLState::getInstance();
+        textureID = GLState::createTexture2D();
+        gl.textureParameter(textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl.textureParameter(textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl.textureParameter(textureID, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
+        gl.textureParameter(textureID, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
+        gl.textureImage2D(textureID, width, height, channels, nullptr);
+    }
+
+    // Rows of `pixels` are tightly packed with this texture's channel count
+    void updateRegion(int x, int y, int regionWidth, int regionHeight, const unsigned char *pixels)
+    {
+        GLState::getInstance().textureSubImage2D(textureID, x, y, regionWidth, regionHeight, nrChannels, pixels);
+    }
+
     // Destructor to clean up the texture
     ~Texture()
     {
-        if (isBound())
-            unbind();
+        GLState::getInstance().forgetTexture(textureID);
         glDeleteTextures(1, &textureID);
     }
+    // Answered from the state cache; never queries the driver
     bool isBound() const
     {
-        GLint currentTexture;
-        glGetIntegerv(GL_TEXTURE_BINDING_2D, &currentTexture);
-        return currentTexture == textureID;
+        return GLState::getInstance().findTexture(textureID) >= 0;
     }
 
-    // Bind the texture with automatic unit selection
-    void bind() const {
-        unit = getNextAvailableUnit();
-        glActiveTexture(unit);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+    // Bind the texture to a texture unit; a no-op when it's already there
+    void bind(int textureUnit = 0) const {
+        GLState::getInstance().bindTexture(textureUnit, textureID);
+        unit = GL_TEXTURE0 + textureUnit;
     }
 
-    // Bind to shader with automatic unit handling
-    void bindToShaderInt(Shader &shader, const std::string &name) const {
+    // Bind and point the shader's sampler at the unit
+    void bindToShaderInt(Shader &shader, const std::string &name, int textureUnit = 0) const {
         shader.use();
-        if (!isBound())
-            bind();
-        int value = unit - GL_TEXTURE0;
-        shader.setInt(name, value);
+        bind(textureUnit);
+        shader.setInt(name, textureUnit);
     }
     GLenum getUnit() const { return unit; }
 
@@ -111,13 +114,11 @@ public:
 
     // Unbind the texture
     void unbind() const {
-        if (!isBound()) // Prevent messing with the outsider textures
+        auto &gl = GLState::getInstance();
+        int bound = gl.findTexture(textureID);
+        if (bound < 0) // Prevent messing with the outsider textures
             return;
-        glBindTexture(GL_TEXTURE_2D, 0);
-        if (unit != GL_TEXTURE0) {
-            releaseUnit(unit);
-            unit = GL_TEXTURE0;
-        }
+        gl.bindTexture(bound, 0);
     }
     std::vector<unsigned char> getBuffer() const {
         return buffer;
@@ -125,33 +126,15 @@ public:
     // Get the width and height of the texture
     int getWidth() const { return width; }
     int getHeight() const { return height; }
+    int getChannels() const { return nrChannels; }
 
     // Get the texture ID
     unsigned int getID() const { return textureID; }
 
 private:
     unsigned int textureID;
-    mutable GLenum unit = GL_TEXTURE0;  // Mutable since it changes in const methods
-    mutable int width, height, nrChannels;
+    mutable GLenum unit = GL_TEXTURE0;  // Last unit bound to; mutable since it changes in const methods
+    mutable int width = 0, height = 0, nrChannels = 0;
     std::vector<unsigned char> buffer;
-
-    static GLenum getNextAvailableUnit() {
-        static std::set<GLenum> usedUnits;
-        
-        // Find first available unit
-        for (GLenum unit = GL_TEXTURE0; unit <= GL_TEXTURE31; unit++) {
-            if (usedUnits.find(unit) == usedUnits.end()) {
-                usedUnits.insert(unit);
-                return unit;
-            }
-        }
-        // If no units available, reuse GL_TEXTURE0
-        return GL_TEXTURE0;
-    }
-
-    static void releaseUnit(GLenum unit) {
-        static std::set<GLenum> usedUnits;
-        usedUnits.erase(unit);
-    }
 };
 #endif // TEXTURE_H
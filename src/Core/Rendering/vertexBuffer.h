@@ -3,7 +3,9 @@
 
 #include <glad/glad.h>
 #include <vector>
+#include <glm/glm.hpp>
 #include "../Util/vertex.h"
+#include "glState.h"
 #include <tuple>
 
 class UV_VertexBuffer: public std::enable_shared_from_this<UV_VertexBuffer>
@@ -12,35 +14,23 @@ public:
     UV_VertexBuffer(const std::vector<Vertex> vertices, const std::vector<unsigned int> indices)
     : vertices(vertices), indices(indices)
     {
-        // Generate and bind VAO
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        auto &gl = GLState::getInstance();
+        VAO = GLState::createVertexArray();
 
-        // Generate and bind VBO
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-        // Generate and bind EBO
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        // Vertex and index buffers
+        VBO = GLState::createBuffer();
+        GLState::bufferData(VBO, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        EBO = GLState::createBuffer();
+        GLState::bufferData(EBO, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
         // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        glEnableVertexAttribArray(0);
-
+        gl.vertexAttrib(VAO, 0, VBO, 3, GL_FLOAT, sizeof(Vertex), 0);
         // Texture coord attribute
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        // Unbind VAO
-        glBindVertexArray(0);
+        gl.vertexAttrib(VAO, 1, VBO, 2, GL_FLOAT, sizeof(Vertex), 3 * sizeof(float));
+        gl.elementBuffer(VAO, EBO);
     }
+    // Checked for every draw, so this must stay free of GL queries
     bool isValid() const {
-        GLint maxVAO = 0;
-        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxVAO);
-        
         if (VAO == 0) {
             std::cout << "Invalid VAO: " << VAO << std::endl;
             return false;
@@ -67,7 +57,7 @@ public:
     ~UV_VertexBuffer()
     {
         // Clean up
-        glBindVertexArray(0);
+        GLState::getInstance().forgetVertexArray(VAO);
         //std::cout << "Deleting buffers: " << VAO << ", " << VBO << ", " << EBO << std::endl;
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
@@ -75,44 +65,55 @@ public:
     }
     bool isActive() const
     {
-        GLint currentVAO;
-        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
-        return currentVAO == VAO;
+        return GLState::getInstance().getVertexArray() == VAO;
     }
 
     void bind() const
     {
-        glBindVertexArray(VAO);
+        GLState::getInstance().bindVertexArray(VAO);
     }
 
     void unbind() const
     {
         if (isActive())
-            glBindVertexArray(0);
+            GLState::getInstance().bindVertexArray(0);
+    }
+
+    // Feeds a mat4 per instance from `buffer`, starting `offset` bytes in, to attributes
+    // location..location + 3. Only re-specified when the buffer or offset changes.
+    void setInstanceBuffer(GLuint buffer, GLint location, std::size_t offset = 0)
+    {
+        if (instanceBuffer == buffer && instanceOffset == offset)
+            return;
+        auto &gl = GLState::getInstance();
+        for (int column = 0; column < 4; column++)
+            gl.vertexAttrib(VAO, location + column, buffer, 4, GL_FLOAT, sizeof(glm::mat4),
+                            offset + column * sizeof(glm::vec4), false, 1);
+        instanceBuffer = buffer;
+        instanceOffset = offset;
     }
 
     void updateVertices(const std::vector<Vertex> &newVertices)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
         if (newVertices.size() * sizeof(Vertex) != vertices.size() * sizeof(Vertex)) {
             // Reallocate buffer if size changed
-            glBufferData(GL_ARRAY_BUFFER, newVertices.size() * sizeof(Vertex), newVertices.data(), GL_STATIC_DRAW);
+            GLState::bufferData(VBO, newVertices.size() * sizeof(Vertex), newVertices.data(), GL_STATIC_DRAW);
         }
         else {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, newVertices.size() * sizeof(Vertex), newVertices.data());
+            GLState::bufferSubData(VBO, 0, newVertices.size() * sizeof(Vertex), newVertices.data());
         }
         vertices = newVertices;
     }
 
     void updateIndices(const std::vector<unsigned int> &newIndices)
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        // Not through GL_ELEMENT_ARRAY_BUFFER: that would rebind whichever VAO is current
         if (newIndices.size() * sizeof(unsigned int) != indices.size() * sizeof(unsigned int)) {
             // Reallocate buffer if size changed
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, newIndices.size() * sizeof(unsigned int), newIndices.data(), GL_STATIC_DRAW);
+            GLState::bufferData(EBO, newIndices.size() * sizeof(unsigned int), newIndices.data(), GL_STATIC_DRAW);
         }
         else {
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, newIndices.size() * sizeof(unsigned int), newIndices.data());
+            GLState::bufferSubData(EBO, 0, newIndices.size() * sizeof(unsigned int), newIndices.data());
         }
         indices = newIndices;
     }
@@ -132,6 +133,8 @@ public:
     }
 private:
     unsigned int VAO, VBO, EBO;
+    GLuint instanceBuffer = 0;
+    std::size_t instanceOffset = 0;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
 };
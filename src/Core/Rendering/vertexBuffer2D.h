@@ -3,46 +3,40 @@
 
 #include <glad/glad.h>
 #include <vector>
+#include <algorithm>
 #include <tuple>
 #include <memory>
 #include <iostream>
 #include "../Util/vertex.h"
+#include "glState.h"
 
+// Streaming quad buffer for 2D batches. Vertices are rewritten every frame into a
+// freshly orphaned store, so the driver never waits on last frame's draws; the index
+// buffer only holds the fixed two-triangle pattern and is rebuilt when capacity grows.
 class VertexBuffer2D: public std::enable_shared_from_this<VertexBuffer2D>
 {
 public:
-    VertexBuffer2D(const std::vector<Vertex2D>& vertices, const std::vector<unsigned int>& indices)
-    : vertices(vertices), indices(indices)
-    {
-        // Generate and bind VAO
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
-
-        // Generate and bind VBO
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex2D), nullptr, GL_DYNAMIC_DRAW); // Will resize as needed
+    static const std::size_t INITIAL_QUADS = 256;
 
-        // Generate and bind EBO
-        glGenBuffers(1, &EBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+    VertexBuffer2D()
+    {
+        auto &gl = GLState::getInstance();
+        VAO = GLState::createVertexArray();
+        VBO = GLState::createBuffer();
+        EBO = GLState::createBuffer();
 
-        // Vertex attribs: pos (2), uv (2), color (4)
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)(sizeof(glm::vec2)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex2D), (void*)(2 * sizeof(glm::vec2)));
-        glEnableVertexAttribArray(2);
+        // Vertex attribs: pos (2), uv (2), color (4), texture slot (1, integer)
+        gl.vertexAttrib(VAO, 0, VBO, 2, GL_FLOAT, sizeof(Vertex2D), offsetof(Vertex2D, pos));
+        gl.vertexAttrib(VAO, 1, VBO, 2, GL_FLOAT, sizeof(Vertex2D), offsetof(Vertex2D, uv));
+        gl.vertexAttrib(VAO, 2, VBO, 4, GL_FLOAT, sizeof(Vertex2D), offsetof(Vertex2D, color));
+        gl.vertexAttrib(VAO, 3, VBO, 1, GL_INT, sizeof(Vertex2D), offsetof(Vertex2D, texIndex), true);
+        gl.elementBuffer(VAO, EBO);
+        gl.bindVertexArray(0);
 
-        // Unbind VAO
-        glBindVertexArray(0);
+        reserveQuads(INITIAL_QUADS);
     }
+    // Checked for every draw, so this must stay free of GL queries
     bool isValid() const {
-        GLint maxVAO = 0;
-        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxVAO);
-        
         if (VAO == 0) {
             std::cout << "Invalid VAO: " << VAO << std::endl;
             return false;
@@ -55,54 +49,48 @@ public:
             std::cout << "Invalid EBO: " << EBO << std::endl;
             return false;
         }
-        if (vertices.empty()) {
-            std::cout << "Empty vertices array" << std::endl;
-            return false;
-        }
-        if (indices.empty()) {
-            std::cout << "Empty indices array" << std::endl;
-            return false;
-        }
         return true;
     }
 
     ~VertexBuffer2D()
     {
         // Clean up
-        glBindVertexArray(0);
-        //std::cout << "Deleting buffers: " << VAO << ", " << VBO << ", " << EBO << std::endl;
+        GLState::getInstance().forgetVertexArray(VAO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
     }
     bool isActive() const
     {
-        GLint currentVAO;
-        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
-        return currentVAO == VAO;
+        return GLState::getInstance().getVertexArray() == VAO;
     }
 
     void bind() const
     {
-        glBindVertexArray(VAO);
+        GLState::getInstance().bindVertexArray(VAO);
     }
 
     void unbind() const
     {
         if (isActive())
-            glBindVertexArray(0);
+            GLState::getInstance().bindVertexArray(0);
     }
 
-    void updateVertices(const std::vector<Vertex2D>& vertices)
+    // Takes four vertices per quad, corners in the order the index pattern expects
+    // (top-left, top-right, bottom-right, bottom-left). Grows the buffers as needed.
+    void uploadQuads(const std::vector<Vertex2D> &vertices)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex2D), vertices.data());
+        std::size_t quads = vertices.size() / 4;
+        if (quads > quadCapacity)
+            reserveQuads(std::max(quads, quadCapacity * 2));
+        // Orphan, then fill: the old store stays with any draw still reading it
+        GLState::bufferData(VBO, quadCapacity * 4 * sizeof(Vertex2D), nullptr, GL_STREAM_DRAW);
+        GLState::bufferSubData(VBO, 0, quads * 4 * sizeof(Vertex2D), vertices.data());
     }
 
-    void updateIndices(const std::vector<unsigned int>& indices)
+    std::size_t getQuadCapacity() const
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+        return quadCapacity;
     }
 
     std::tuple<unsigned int, unsigned int, unsigned int> getBuffers() const
@@ -110,19 +98,23 @@ public:
         return std::make_tuple(VAO, VBO, EBO);
     }
 
-    const std::vector<unsigned int>& getIndices() const
-    {
-        return indices;
-    }
-    unsigned int getIndexCount() const
-    {
-        return static_cast<unsigned int>(indices.size());
-    }
-
 private:
     unsigned int VAO, VBO, EBO;
-    const std::vector<Vertex2D>& vertices;
-    const std::vector<unsigned int>& indices;
+    std::size_t quadCapacity = 0;
+
+    void reserveQuads(std::size_t quads)
+    {
+        std::vector<unsigned int> indices;
+        indices.reserve(quads * 6);
+        for (std::size_t i = 0; i < quads; i++)
+        {
+            unsigned int base = static_cast<unsigned int>(i * 4);
+            indices.insert(indices.end(), {base + 0, base + 1, base + 2, base + 2, base + 3, base + 0});
+        }
+        GLState::bufferData(EBO, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        GLState::bufferData(VBO, quads * 4 * sizeof(Vertex2D), nullptr, GL_STREAM_DRAW);
+        quadCapacity = quads;
+    }
 };
 
 #endif // Vertex2D_BUFFER_H
@@ -0,0 +1,85 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+
+// Fixed-capacity least-recently-used cache. Not thread safe on its own;
+// owners that share it across threads guard it with their own mutex.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LRUCache
+{
+public:
+    explicit LRUCache(std::size_t capacity = 64) : capacity(capacity) {}
+
+    // Returns a pointer to the cached value (and marks it most recently used), or nullptr
+    Value *get(const Key &key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    // Inserts or replaces a value, evicting the least recently used entry when full
+    Value &put(const Key &key, Value value)
+    {
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
+        }
+
+        if (capacity > 0 && entries.size() >= capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, std::move(value));
+        index[key] = entries.begin();
+        return entries.front().second;
+    }
+
+    bool erase(const Key &key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return false;
+        entries.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        index.clear();
+    }
+
+    void setCapacity(std::size_t newCapacity)
+    {
+        capacity = newCapacity;
+        while (capacity > 0 && entries.size() > capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    std::size_t size() const { return entries.size(); }
+    std::size_t getCapacity() const { return capacity; }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    std::size_t capacity;
+    std::list<Entry> entries; // Front is most recently used
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+};
+
+#endif // LRU_CACHE_H
@@ -0,0 +1,105 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when the caller doesn't pick one
+inline unsigned int getDefaultWorkerCount()
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 4;
+}
+
+using ParallelProgressCallback = std::function<void(std::size_t done, std::size_t total)>;
+
+// Fork-join loop: runs body(i) for every i in [0, count) across `threads` threads
+// (the calling thread included) and returns once all of them are finished.
+// Items are handed out through a shared counter, so the order they run in is
+// unspecified; bodies must only write to their own slot of any shared output.
+// onProgress is only ever invoked on the calling thread.
+// The first exception thrown by a body is rethrown here after all threads join.
+template <typename Body>
+void parallelFor(std::size_t count, Body &&body, unsigned int threads = 0,
+                 const ParallelProgressCallback &onProgress = nullptr)
+{
+    if (count == 0)
+        return;
+    if (threads == 0)
+        threads = getDefaultWorkerCount();
+    if (threads > count)
+        threads = static_cast<unsigned int>(count);
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> done{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable progressCV;
+
+    auto worker = [&]()
+    {
+        while (!failed.load())
+        {
+            std::size_t i = next.fetch_add(1);
+            if (i >= count)
+                break;
+            try
+            {
+                body(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                failed.store(true);
+            }
+            done.fetch_add(1);
+            progressCV.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+
+    worker();
+
+    // Keep reporting on the calling thread while the rest of the pool drains
+    if (onProgress)
+    {
+        std::size_t reported = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!failed.load())
+        {
+            std::size_t current = done.load();
+            if (current != reported)
+            {
+                reported = current;
+                lock.unlock();
+                onProgress(reported, count);
+                lock.lock();
+            }
+            if (reported >= count)
+                break;
+            progressCV.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    for (auto &thread : pool)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,86 @@
+#ifndef RANGE_ALLOCATOR_H
+#define RANGE_ALLOCATOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+// First-fit sub-allocator over [0, capacity) in abstract units (vertices, indices, bytes...).
+// Only bookkeeping: the caller owns the storage. Freed ranges merge with their neighbours.
+class RangeAllocator
+{
+public:
+    static const std::size_t INVALID = static_cast<std::size_t>(-1);
+
+    explicit RangeAllocator(std::size_t capacity = 0) : capacity(0)
+    {
+        grow(capacity);
+    }
+
+    // Returns the offset of a free range of `size` units, or INVALID when none is large enough
+    std::size_t allocate(std::size_t size)
+    {
+        if (size == 0)
+            return INVALID;
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+        {
+            if (it->second < size)
+                continue;
+            std::size_t offset = it->first;
+            std::size_t remaining = it->second - size;
+            freeRanges.erase(it);
+            if (remaining > 0)
+                freeRanges[offset + size] = remaining;
+            used += size;
+            return offset;
+        }
+        return INVALID;
+    }
+
+    void free(std::size_t offset, std::size_t size)
+    {
+        if (offset == INVALID || size == 0)
+            return;
+        used -= size;
+
+        auto next = freeRanges.lower_bound(offset);
+        if (next != freeRanges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = freeRanges.erase(next);
+        }
+        if (next != freeRanges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += size;
+                return;
+            }
+        }
+        freeRanges[offset] = size;
+    }
+
+    // Extends the managed range; existing allocations keep their offsets
+    void grow(std::size_t newCapacity)
+    {
+        if (newCapacity <= capacity)
+            return;
+        std::size_t added = newCapacity - capacity;
+        std::size_t oldCapacity = capacity;
+        capacity = newCapacity;
+        used += added; // free() subtracts it again
+        free(oldCapacity, added);
+    }
+
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getUsed() const { return used; }
+    std::size_t getFreeRangeCount() const { return freeRanges.size(); }
+
+private:
+    std::size_t capacity;
+    std::size_t used = 0;
+    std::map<std::size_t, std::size_t> freeRanges; // Offset -> size
+};
+
+#endif // RANGE_ALLOCATOR_H
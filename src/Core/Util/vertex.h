@@ -8,6 +8,7 @@ struct Vertex2D {
     glm::vec2 pos;
     glm::vec2 uv;
     glm::vec4 color;
+    int texIndex; // Texture slot of the batch, -1 for untextured
 };
 
 struct Vertex {
@@ -0,0 +1,148 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fork-join loop like parallelFor, on threads that are started once and then wait for
+// work, for loops that run every frame and are too short to pay for creating threads.
+// run() hands out items through a shared counter and the calling thread helps, so
+// the same rules apply: bodies only write to their own slot of any shared output, and
+// the first exception thrown by a body is rethrown by run() once the loop is done.
+// Only one thread may call run() at a time.
+class WorkerPool
+{
+public:
+    // `threads` counts the calling thread, so one less is started
+    explicit WorkerPool(unsigned int threads)
+    {
+        for (unsigned int t = 1; t < threads; t++)
+            workers.emplace_back([this]()
+                                 { workerLoop(); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeCV.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    template <typename Body>
+    void run(std::size_t count, Body &&body)
+    {
+        if (count == 0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // A plain pointer and trampoline, so starting a loop never allocates
+            context = const_cast<void *>(static_cast<const void *>(&body));
+            invoke = [](void *target, std::size_t i)
+            { (*static_cast<std::remove_reference_t<Body> *>(target))(i); };
+            itemCount = count;
+            next.store(0);
+            failed.store(false);
+            error = nullptr;
+            open = true;
+            generation++;
+        }
+        wakeCV.notify_all();
+
+        work();
+
+        // Every item is taken by now. Workers that haven't woken yet would find nothing
+        // left, so the loop is closed to them and only the ones inside it are waited for.
+        std::unique_lock<std::mutex> lock(mutex);
+        open = false;
+        doneCV.wait(lock, [this]()
+                    { return busyWorkers == 0; });
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeCV;
+    std::condition_variable doneCV;
+
+    // The current loop, guarded by mutex; workers copy what they need when they wake
+    void *context = nullptr;
+    void (*invoke)(void *, std::size_t) = nullptr;
+    std::size_t itemCount = 0;
+    std::size_t busyWorkers = 0; // Workers inside the current loop
+    unsigned long long generation = 0;
+    bool open = false; // Whether workers may still join the current loop
+    bool stopRequested = false;
+    std::exception_ptr error;
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+
+    void work()
+    {
+        while (!failed.load())
+        {
+            std::size_t i = next.fetch_add(1);
+            if (i >= itemCount)
+                break;
+            try
+            {
+                invoke(context, i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+                failed.store(true);
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeCV.wait(lock, [&]()
+                            { return stopRequested || generation != seen; });
+                if (stopRequested)
+                    return;
+                seen = generation;
+                if (!open)
+                    continue;
+                busyWorkers++;
+            }
+
+            work();
+
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                last = --busyWorkers == 0;
+            }
+            if (last)
+                doneCV.notify_one();
+        }
+    }
+};
+
+#endif // WORKER_POOL_H
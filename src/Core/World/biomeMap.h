@@ -0,0 +1,166 @@
+#ifndef BIOME_MAP_H
+#define BIOME_MAP_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include "perlinNoise.h"
+#include "../Util/lruCache.h"
+
+struct BiomeTileHash
+{
+    std::size_t operator()(const glm::ivec2 &k) const
+    {
+        return std::hash<int>()(k.x) ^ (std::hash<int>()(k.y) << 1);
+    }
+};
+
+// Low resolution biome samples for one square region of the world.
+// Values are stored on a grid with one sample every `resolution` blocks,
+// including the far edge so lookups never need a neighbouring tile.
+struct BiomeTile
+{
+    glm::ivec2 origin;   // World block coordinate of sample (0, 0)
+    int resolution;      // Blocks between samples
+    int samplesPerSide;  // TILE_SIZE / resolution + 1
+    std::vector<float> samples;
+
+    float at(int sx, int sz) const { return samples[sz * samplesPerSide + sx]; }
+};
+
+// World-level biome map shared by every generation stage. Tiles are built
+// lazily from the biome noise and kept in an LRU cache keyed by tile coord,
+// so neighbouring chunks reuse the same samples instead of re-evaluating noise.
+class BiomeMap
+{
+public:
+    static const int TILE_SIZE = 256; // Blocks per tile side
+
+    BiomeMap(const PerlinNoise &noise, float scale, int resolution = 4, std::size_t cachedTiles = 64)
+        : noise(noise), scale(scale), resolution(resolution), cache(cachedTiles)
+    {
+        if (this->resolution <= 0 || TILE_SIZE % this->resolution != 0)
+            this->resolution = 4;
+    }
+
+    // Must be called before generation starts; drops every cached tile
+    void configure(float newScale, int newResolution)
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        scale = newScale;
+        if (newResolution > 0 && TILE_SIZE % newResolution == 0)
+            resolution = newResolution;
+        cache.clear();
+    }
+
+    // Biome value in [0, 1] at a world block column
+    float sample(int x, int z) const
+    {
+        auto tile = getTile(tileCoord(x), tileCoord(z));
+        return interpolate(*tile, x, z);
+    }
+
+    // Evaluates the noise directly, bypassing the tile cache. For sparse lookups far
+    // apart, where building a whole tile per sample would cost far more than the sample.
+    float sampleUncached(int x, int z) const
+    {
+        return evaluate(x, z);
+    }
+
+    // Fills `out` (width * depth, row-major by z) with biome values for a block area.
+    // Tiles are fetched once per area rather than once per column.
+    void sampleArea(int x0, int z0, int width, int depth, float *out) const
+    {
+        std::shared_ptr<const BiomeTile> tile;
+        glm::ivec2 current(0);
+        for (int z = 0; z < depth; z++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                int wx = x0 + x;
+                int wz = z0 + z;
+                glm::ivec2 coord(tileCoord(wx), tileCoord(wz));
+                if (!tile || coord != current)
+                {
+                    tile = getTile(coord.x, coord.y);
+                    current = coord;
+                }
+                out[z * width + x] = interpolate(*tile, wx, wz);
+            }
+        }
+    }
+
+    std::size_t getCachedTileCount() const
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return cache.size();
+    }
+
+private:
+    const PerlinNoise &noise;
+    float scale;
+    int resolution;
+
+    mutable std::mutex cacheMutex;
+    mutable LRUCache<glm::ivec2, std::shared_ptr<const BiomeTile>, BiomeTileHash> cache;
+
+    // Floor division in integers; a float quotient loses the low bits far from the origin
+    static int tileCoord(int block)
+    {
+        return block >= 0 ? block / TILE_SIZE : -((-(block + 1)) / TILE_SIZE) - 1;
+    }
+
+    float evaluate(int x, int z) const
+    {
+        float biome = static_cast<float>(noise.noise(x * scale, 0, z * scale));
+        return glm::clamp(biome, 0.0f, 1.0f);
+    }
+
+    std::shared_ptr<const BiomeTile> getTile(int tileX, int tileZ) const
+    {
+        glm::ivec2 key(tileX, tileZ);
+        int res;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (auto *cached = cache.get(key))
+                return *cached;
+            res = resolution;
+        }
+
+        // Build outside the lock; a racing thread may build the same tile, which is harmless
+        auto tile = std::make_shared<BiomeTile>();
+        tile->origin = key * TILE_SIZE;
+        tile->resolution = res;
+        tile->samplesPerSide = TILE_SIZE / res + 1;
+        tile->samples.resize(tile->samplesPerSide * tile->samplesPerSide);
+        for (int sz = 0; sz < tile->samplesPerSide; sz++)
+        {
+            for (int sx = 0; sx < tile->samplesPerSide; sx++)
+            {
+                tile->samples[sz * tile->samplesPerSide + sx] =
+                    evaluate(tile->origin.x + sx * res, tile->origin.y + sz * res);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.put(key, tile);
+        return tile;
+    }
+
+    static float interpolate(const BiomeTile &tile, int x, int z)
+    {
+        int localX = x - tile.origin.x;
+        int localZ = z - tile.origin.y;
+        int sx = localX / tile.resolution;
+        int sz = localZ / tile.resolution;
+        float fx = static_cast<float>(localX % tile.resolution) / tile.resolution;
+        float fz = static_cast<float>(localZ % tile.resolution) / tile.resolution;
+
+        float top = glm::mix(tile.at(sx, sz), tile.at(sx + 1, sz), fx);
+        float bottom = glm::mix(tile.at(sx, sz + 1), tile.at(sx + 1, sz + 1), fx);
+        return glm::mix(top, bottom, fz);
+    }
+};
+
+#endif // BIOME_MAP_H
@@ -6,14 +6,19 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <algorithm>
 #include "../transform.h"
-#include "../Rendering/meshRenderer.h"
-#include "../Renderer/renderer.h"
+#include "../Rendering/mesh.h"
 #include "../object.h"
-#include "../assets.h"
 #include "../Block/block.h"
+#include "../Block/blockDatabase.h"
 #include "../Util/vertex.h"
 #include "../Util/spatialMesh.h"
+#include "../Debug/traceRecorder.h"
+#include "../Debug/metrics.h"
+#include "../Debug/allocationTracker.h"
+#include "heightmap.h"
+#include "sectionVisibility.h"
 #include <array>
 
 enum class ChunkState
@@ -30,11 +35,37 @@ enum class ChunkMeshState
     READY
 };
 
+class Chunk;
+
+// Client-side state attached to a chunk, such as its GPU buffers (see ChunkRenderer).
+// The world never looks inside; it only lives as long as the chunk.
+class ChunkRenderState
+{
+public:
+    virtual ~ChunkRenderState() = default;
+};
+
+// Sees every mesh right after it's built, on the thread that built it, so a client can
+// start moving it to the GPU from the worker (see ChunkRenderer)
+class ChunkMeshListener
+{
+public:
+    virtual ~ChunkMeshListener() = default;
+    virtual void onMeshBuilt(Chunk &chunk) = 0;
+};
+
+// Block data, heightmap and CPU mesh of a 16x16 column of the world. Nothing in here
+// needs a GL context; drawing is the client's business (see ChunkRenderer).
 class Chunk : public Object
 {
 public:
     static const int CHUNK_SIZE = 16;
     static const int CHUNK_HEIGHT = 256;
+    static const int SECTION_COUNT = CHUNK_HEIGHT / SectionVisibility::SIZE;
+    // Level 0 is one block per voxel; level n merges 2^n blocks per axis
+    static const int LOD_COUNT = 4;
+    static_assert(ChunkHeightmap::SIZE == CHUNK_SIZE, "Heightmap must cover one chunk");
+    static_assert(SectionVisibility::SIZE == CHUNK_SIZE, "Sections must be cubes");
 
     Chunk(const std::string &name = "Chunk") : Object(name)
     {
@@ -42,146 +73,148 @@ public:
         AddAncestorClass("Chunk");
 
         // Initialize the blocks array
-        blocks.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_HEIGHT, nullptr);
+        blocks.resize(CHUNK_SIZE * CHUNK_SIZE * CHUNK_HEIGHT, BLOCK_TYPE_AIR);
 
-        // Create mesh renderer with transform
         transform = std::make_shared<Transform>();
-        meshRenderer = std::make_shared<UV_MeshRenderer>(transform);
-
-        // Get the terrain texture from asset manager
-        auto &assets = AssetManager::getInstance();
-        auto texture = assets.getTexture("terrain");
-        auto shader = assets.getShader("default");
-
-        if (!texture || !shader)
-        {
-            throw std::runtime_error("Required assets not found");
-        }
-        meshRenderer->Initialize(transform, nullptr, shader, texture);
     }
 
+    ~Chunk() { trackMeshBytes(0); }
 
-    void setBlock(int x, int y, int z, BlockType type)
+
+    // updateHeightmap can be turned off by bulk writers that set the columns themselves
+    void setBlock(int x, int y, int z, BlockType type, bool updateHeightmap = true)
     {
-        if (!isValidPosition(x, y, z))
+        if (!isValidPosition(x, y, z) || !hasBlockData())
             return;
 
         int index = getIndex(x, y, z);
+        blocks[index] = static_cast<uint8_t>(type);
 
-        if (type == BLOCK_TYPE_AIR)
-        {
-            // Remove the block if it exists
-            blocks[index] = nullptr;
-        }
-        else
-        {
-            if (!blocks[index])
-            {
-                blocks[index] = std::make_shared<Block>("Block",
-                                                        glm::vec3(x, y, z), type);
-            }
-            else
-            {
-                blocks[index]->setType(type);
-            }
-        }
-
+        if (updateHeightmap)
+            updateHeightmapColumn(x, y, z, type);
+        modified = true;
         meshState.store(ChunkMeshState::OUTDATED);
     }
 
+    // A player's edit: setBlock, plus the time of the oldest edit not drawn yet, which the
+    // client turns into edit-to-visible latency (see takeEditTime)
+    void editBlock(int x, int y, int z, BlockType type)
+    {
+        setBlock(x, y, z, type);
+        std::uint64_t none = 0;
+        editTime.compare_exchange_strong(none, Metrics::now());
+    }
+
+    // Metrics::now() of the oldest edit since the last call, or 0 without one
+    std::uint64_t takeEditTime() { return editTime.exchange(0); }
+
+    // Coarser chunks are meshed from merged voxels and drop their block data afterwards.
+    // Set before the first mesh build.
+    void setLod(int level) { lod = std::clamp(level, 0, LOD_COUNT - 1); }
+    int getLod() const { return lod; }
+
+    // False once a coarse chunk has been meshed; getBlock then reports air everywhere
+    bool hasBlockData() const { return !blocks.empty(); }
+
+    // Edited since generation; the streamer keeps these instead of regenerating them
+    bool isModified() const { return modified; }
+    void setModified(bool value) { modified = value; }
+
+    const ChunkHeightmap &getHeightmap() const { return heightmap; }
+
+    // Used by the generator, which already knows the surface of every column
+    void setHeightmapColumn(int x, int z, int topSolid, int topOpaque)
+    {
+        heightmap.setColumn(x, z, topSolid, topOpaque);
+    }
+
     BlockType getBlock(int x, int y, int z) const
     {
-        if (!isValidPosition(x, y, z))
+        if (!isValidPosition(x, y, z) || !hasBlockData())
             return BLOCK_TYPE_AIR;
-
-        int index = getIndex(x, y, z);
-        return blocks[index] ? blocks[index]->getType() : BLOCK_TYPE_AIR;
+        return static_cast<BlockType>(blocks[getIndex(x, y, z)]);
     }
 
-    void updateMesh()
+    // Builds the mesh on the calling thread; the listener sees it before anyone else
+    void updateMesh(ChunkMeshListener *listener = nullptr)
     {
         if (meshState.load() != ChunkMeshState::OUTDATED)
             return;
+        VOXELC_TRACE_SCOPE("updateMesh", "mesh");
+        AllocationScope allocations(ALLOC_MESH);
+        static MetricCounter &meshed = Metrics::counter("chunks.meshed");
         meshState.store(ChunkMeshState::GENERATING);
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
-        // For each block in the chunk
-        for (int x = 0; x < CHUNK_SIZE; x++)
-        {
-            for (int y = 0; y < CHUNK_HEIGHT; y++)
-            {
-                for (int z = 0; z < CHUNK_SIZE; z++)
-                {
-                    auto block = getBlock(x, y, z);
-                    if (block == BLOCK_TYPE_AIR)
-                        continue;
-
-                    // Get block info from database
-                    const auto &blockInfo = BlockDatabase::getBlockInfo(block);
-
-                    // Add block mesh vertices with offset
-                    auto &blockMesh = blockInfo.mesh;
-                    size_t baseIndex = vertices.size();
-
-                    for (const auto &vertex : blockMesh->vertices)
-                    {
-                        Vertex v = vertex;
-                        v.x += x;
-                        v.y += y;
-                        v.z += z;
-                        vertices.push_back(v);
-                    }
-
-                    // Add indices with offset
-                    for (auto index : blockMesh->indices)
-                    {
-                        indices.push_back(index + baseIndex);
-                    }
-                }
-            }
-        }
+        // Nothing above the highest solid block needs visiting
+        int maxY = heightmap.getMaxSolid();
+        if (lod == 0)
+            buildBlockMesh(maxY, vertices, indices);
+        else
+            buildLodMesh(maxY, vertices, indices);
+        for (int section = (maxY + SectionVisibility::SIZE) / SectionVisibility::SIZE; section <= SECTION_COUNT; section++)
+            sectionIndexOffsets[section] = static_cast<unsigned int>(indices.size());
+        // Coarse chunks sit past the range the section search covers; keep them fully connected
+        updateSectionVisibility(lod == 0 ? maxY : ChunkHeightmap::NO_BLOCK);
 
         if (vertices.empty() || indices.empty()) {
             std::cout << "Warning: Generated empty mesh for chunk at " << position.x << "," << position.y << "," << position.z << std::endl;
         }
         // Create or update the mesh
         mesh = std::make_shared<UV_Mesh>(vertices, indices);
-        // meshRenderer->setMesh(mesh); calls opengl functions; only call on renderer thread ):<
+        trackMeshBytes(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
+        meshed.add();
+        if (listener)
+            listener->onMeshBuilt(*this);
 
-        // Update or create the spatial mesh
-        if (!spatialMesh)
-            spatialMesh = std::make_shared<SpatialMesh>();
-        spatialMesh->loadFromMesh(*mesh, transform);
-        // Optionally, for blocky chunks:
-        spatialMesh->calculateBlockAABBs(1.0f); // 1.0f if blocks are 1x1x1
+        if (lod == 0)
+        {
+            // Update or create the spatial mesh
+            if (!spatialMesh)
+                spatialMesh = std::make_shared<SpatialMesh>();
+            spatialMesh->loadFromMesh(*mesh, transform);
+            // Optionally, for blocky chunks:
+            spatialMesh->calculateBlockAABBs(1.0f); // 1.0f if blocks are 1x1x1
+        }
+        else
+        {
+            // Far chunks are only ever looked at; the mesh is all that's needed from here on
+            blocks.clear();
+            blocks.shrink_to_fit();
+        }
 
         meshState.store(ChunkMeshState::QUEUED);
         setState(ChunkState::READY);
     }
 
-    void queueToRenderer(std::shared_ptr<Renderer> renderer)
-    {
-        if (!isReady())
-            return;
+    ChunkMeshState getMeshState() const { return meshState.load(); }
 
-        if (meshState.load() == ChunkMeshState::OUTDATED)
-        {
-            updateMesh();
-            if (mesh)
-            {
-                meshRenderer->setMesh(mesh);
-                meshState.store(ChunkMeshState::READY);
-            }
-        } else if (meshState.load() == ChunkMeshState::QUEUED && mesh)
-        {
-            meshRenderer->setMesh(mesh);
-            meshState.store(ChunkMeshState::READY);
-        }
-        if (meshRenderer && meshState.load() == ChunkMeshState::READY)
+    // The last mesh built; coarse chunks may drop it once the client has its own copy
+    std::shared_ptr<UV_Mesh> getMesh() const { return mesh; }
+
+    // Called by the client once the mesh is on the GPU. A coarse chunk can't be rebuilt,
+    // so it may let go of the CPU copy when the GPU one is all that's needed.
+    void setMeshUploaded(bool releaseMesh)
+    {
+        if (releaseMesh)
         {
-            meshRenderer->queueToRender(renderer);
+            mesh.reset();
+            trackMeshBytes(0);
         }
+        meshState.store(ChunkMeshState::READY);
     }
+
+    // Index range of the sections picked by setVisibleSections
+    void getVisibleIndexRange(unsigned int &first, unsigned int &count) const
+    {
+        first = sectionIndexOffsets[visibleSectionsBegin];
+        count = sectionIndexOffsets[visibleSectionsEnd] - first;
+    }
+
+    std::shared_ptr<Transform> getTransform() const { return transform; }
+
+    ChunkRenderState *getRenderState() const { return renderState.get(); }
+    void setRenderState(std::shared_ptr<ChunkRenderState> state) { renderState = std::move(state); }
     bool isReady() const
     {
         return state.load() == ChunkState::READY;
@@ -208,9 +241,39 @@ public:
         return position;
     }
 
+    // World-space box around the occupied part of the chunk; false if the chunk is empty
+    bool getBounds(glm::vec3 &min, glm::vec3 &max) const
+    {
+        int top = heightmap.getMaxSolid();
+        if (top == ChunkHeightmap::NO_BLOCK)
+            return false;
+        min = position;
+        max = position + glm::vec3(CHUNK_SIZE, top + 1, CHUNK_SIZE);
+        return true;
+    }
+
     std::shared_ptr<SpatialMesh> getSpatialMesh() const { return spatialMesh; }
 
+    // Face connectivity of a section as of the last mesh rebuild
+    const SectionVisibility &getSectionVisibility(int section) const { return sectionVisibility[section]; }
+    bool hasSectionGeometry(int section) const { return sectionIndexOffsets[section + 1] > sectionIndexOffsets[section]; }
+
+    // Limits drawing to sections [begin, end); reset to the whole chunk when not culling
+    void setVisibleSections(int begin, int end)
+    {
+        visibleSectionsBegin = begin;
+        visibleSectionsEnd = end;
+    }
+
 private:
+    // CPU mesh memory across all chunks, as a gauge
+    void trackMeshBytes(std::size_t bytes)
+    {
+        static MetricGauge &resident = Metrics::gauge("mesh.cpu_bytes");
+        resident.add(static_cast<std::int64_t>(bytes) - static_cast<std::int64_t>(meshBytes));
+        meshBytes = bytes;
+    }
+
     bool isValidPosition(int x, int y, int z) const
     {
         return x >= 0 && x < CHUNK_SIZE &&
@@ -222,14 +285,204 @@ private:
     {
         return (y * CHUNK_SIZE * CHUNK_SIZE) + (z * CHUNK_SIZE) + x;
     }
+
+    // Incremental update after a single block change: raising is O(1),
+    // lowering only rescans the column below the removed top block
+    void updateHeightmapColumn(int x, int y, int z, BlockType type)
+    {
+        int topSolid = heightmap.getTopSolid(x, z);
+        int topOpaque = heightmap.getTopOpaque(x, z);
+
+        if (isBlockSolid(type))
+            topSolid = std::max(topSolid, y);
+        else if (y == topSolid)
+            topSolid = scanDown(x, y - 1, z, isBlockSolid);
+
+        if (isBlockOpaque(type))
+            topOpaque = std::max(topOpaque, y);
+        else if (y == topOpaque)
+            topOpaque = scanDown(x, y - 1, z, isBlockOpaque);
+
+        heightmap.setColumn(x, z, topSolid, topOpaque);
+    }
+
+    // Full-resolution mesh with faces between two opaque blocks left out.
+    // y runs outermost so each section's indices form one contiguous range.
+    void buildBlockMesh(int maxY, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        for (int y = 0; y <= maxY; y++)
+        {
+            if (y % SectionVisibility::SIZE == 0)
+                sectionIndexOffsets[y / SectionVisibility::SIZE] = static_cast<unsigned int>(indices.size());
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                {
+                    auto block = getBlock(x, y, z);
+                    if (block == BLOCK_TYPE_AIR)
+                        continue;
+
+                    // Get block info from database
+                    const auto &blockMesh = *BlockDatabase::getBlockInfo(block).mesh;
+                    for (int face = 0; face < BLOCK_FACE_COUNT; face++)
+                    {
+                        if (isFaceHidden(glm::ivec3(x, y, z) + getBlockFaceNormal(face), CHUNK_SIZE, CHUNK_HEIGHT,
+                                         [this](int nx, int ny, int nz)
+                                         { return isBlockOpaque(getBlock(nx, ny, nz)); }))
+                            continue;
+                        appendFace(blockMesh, face, glm::vec3(x, y, z), 1.0f, vertices, indices);
+                    }
+                }
+            }
+        }
+    }
+
+    // Mesh of 2^lod-block cells. A cell is solid when at least half of its blocks are
+    // (majority rule) and takes the most common block among its blocks that face up into
+    // air, so grass-topped ground stays grass. Faces on the chunk's sides are always kept:
+    // they act as skirts that hide the cracks where a neighbour uses another level.
+    void buildLodMesh(int maxY, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        const int scale = 1 << lod;
+        const int cellsXZ = CHUNK_SIZE / scale;
+        const int cellsY = (maxY + scale) / scale;
+        const int volume = scale * scale * scale;
+        auto cellIndex = [cellsXZ](int cx, int cy, int cz)
+        { return (cy * cellsXZ + cz) * cellsXZ + cx; };
+
+        std::vector<uint8_t> cells(cellsXZ * cellsXZ * std::max(cellsY, 0), BLOCK_TYPE_AIR);
+        for (int cy = 0; cy < cellsY; cy++)
+        {
+            for (int cz = 0; cz < cellsXZ; cz++)
+            {
+                for (int cx = 0; cx < cellsXZ; cx++)
+                {
+                    int solid = 0;
+                    std::array<int, BLOCK_TYPE_AIR> all{}, surface{};
+                    for (int y = cy * scale; y < (cy + 1) * scale; y++)
+                    {
+                        for (int z = cz * scale; z < (cz + 1) * scale; z++)
+                        {
+                            for (int x = cx * scale; x < (cx + 1) * scale; x++)
+                            {
+                                BlockType block = getBlock(x, y, z);
+                                if (block == BLOCK_TYPE_AIR)
+                                    continue;
+                                solid++;
+                                all[block]++;
+                                if (getBlock(x, y + 1, z) == BLOCK_TYPE_AIR)
+                                    surface[block]++;
+                            }
+                        }
+                    }
+                    if (solid * 2 < volume)
+                        continue;
+                    bool hasSurface = std::any_of(surface.begin(), surface.end(), [](int count)
+                                                  { return count > 0; });
+                    const auto &votes = hasSurface ? surface : all;
+                    cells[cellIndex(cx, cy, cz)] = static_cast<uint8_t>(std::max_element(votes.begin(), votes.end()) - votes.begin());
+                }
+            }
+        }
+
+        for (int cy = 0; cy < cellsY; cy++)
+        {
+            if ((cy * scale) % SectionVisibility::SIZE == 0)
+                sectionIndexOffsets[cy * scale / SectionVisibility::SIZE] = static_cast<unsigned int>(indices.size());
+            for (int cz = 0; cz < cellsXZ; cz++)
+            {
+                for (int cx = 0; cx < cellsXZ; cx++)
+                {
+                    auto cell = static_cast<BlockType>(cells[cellIndex(cx, cy, cz)]);
+                    if (cell == BLOCK_TYPE_AIR)
+                        continue;
+                    const auto &blockMesh = *BlockDatabase::getBlockInfo(cell).mesh;
+                    for (int face = 0; face < BLOCK_FACE_COUNT; face++)
+                    {
+                        if (isFaceHidden(glm::ivec3(cx, cy, cz) + getBlockFaceNormal(face), cellsXZ, cellsY,
+                                         [&](int nx, int ny, int nz)
+                                         { return cells[cellIndex(nx, ny, nz)] != BLOCK_TYPE_AIR; }))
+                            continue;
+                        appendFace(blockMesh, face, glm::vec3(cx, cy, cz) * float(scale), float(scale), vertices, indices);
+                    }
+                }
+            }
+        }
+    }
+
+    // Whether the neighbour at `n` covers the face towards it. Neighbours in other chunks are
+    // unknown, so side faces stay; below the grid is the world floor, which is never seen.
+    template <typename IsOpaque>
+    static bool isFaceHidden(const glm::ivec3 &n, int sizeXZ, int sizeY, IsOpaque isOpaque)
+    {
+        if (n.y < 0)
+            return true;
+        if (n.y >= sizeY || n.x < 0 || n.x >= sizeXZ || n.z < 0 || n.z >= sizeXZ)
+            return false;
+        return isOpaque(n.x, n.y, n.z);
+    }
+
+    // Copies one face of a unit block mesh, stretched to cover `scale` blocks from `corner`
+    static void appendFace(const UV_Mesh &blockMesh, int face, const glm::vec3 &corner, float scale,
+                           std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        unsigned int base = static_cast<unsigned int>(vertices.size());
+        for (int i = 0; i < 4; i++)
+        {
+            Vertex v = blockMesh.vertices[face * 4 + i];
+            // Block meshes span -0.5..0.5 around the block's position
+            v.x = corner.x - 0.5f + (v.x + 0.5f) * scale;
+            v.y = corner.y - 0.5f + (v.y + 0.5f) * scale;
+            v.z = corner.z - 0.5f + (v.z + 0.5f) * scale;
+            vertices.push_back(v);
+        }
+        for (int i = 0; i < 6; i++)
+            indices.push_back(blockMesh.indices[face * 6 + i] - face * 4 + base);
+    }
+
+    // Sections above the terrain are plain air and keep the default, fully connected graph
+    void updateSectionVisibility(int maxY)
+    {
+        for (int section = 0; section < SECTION_COUNT; section++)
+        {
+            int baseY = section * SectionVisibility::SIZE;
+            sectionVisibility[section] = SectionVisibility();
+            if (baseY > maxY)
+                continue;
+            sectionVisibility[section].compute([this, baseY](int x, int y, int z)
+                                               { return isBlockOpaque(getBlock(x, baseY + y, z)); });
+        }
+    }
+
+    int scanDown(int x, int fromY, int z, bool (*matches)(BlockType)) const
+    {
+        for (int y = fromY; y >= 0; y--)
+        {
+            if (matches(getBlock(x, y, z)))
+                return y;
+        }
+        return ChunkHeightmap::NO_BLOCK;
+    }
+
+
     std::shared_ptr<SpatialMesh> spatialMesh; // Add this line
     std::shared_ptr<UV_Mesh> mesh;
     std::atomic<ChunkState> state{ChunkState::UNLOADED};
     std::atomic<ChunkMeshState> meshState{ChunkMeshState::OUTDATED};
-    std::vector<std::shared_ptr<Block>> blocks;
-    std::shared_ptr<UV_MeshRenderer> meshRenderer;
+    std::atomic<std::uint64_t> editTime{0};
+    std::size_t meshBytes = 0; // This chunk's share of the "mesh.cpu_bytes" gauge
+    std::vector<uint8_t> blocks; // BlockType per block; emptied once a coarse chunk is meshed
+    std::shared_ptr<ChunkRenderState> renderState;
     std::shared_ptr<Transform> transform;
     glm::vec3 position{0.0f};
+    ChunkHeightmap heightmap;
+
+    std::array<SectionVisibility, SECTION_COUNT> sectionVisibility;
+    std::array<unsigned int, SECTION_COUNT + 1> sectionIndexOffsets{}; // Index range of each section in the mesh
+    int visibleSectionsBegin = 0;
+    int visibleSectionsEnd = SECTION_COUNT;
+    int lod = 0;
+    bool modified = false;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+// Per-column surface heights for one chunk. Heights are block y coordinates;
+// NO_BLOCK marks a column with nothing in it.
+struct ChunkHeightmap
+{
+    static const int SIZE = 16;
+    static constexpr int16_t NO_BLOCK = -1;
+
+    std::array<int16_t, SIZE * SIZE> topSolid;  // Highest block that isn't air
+    std::array<int16_t, SIZE * SIZE> topOpaque; // Highest block that blocks light and sight
+
+    ChunkHeightmap()
+    {
+        topSolid.fill(NO_BLOCK);
+        topOpaque.fill(NO_BLOCK);
+    }
+
+    int getTopSolid(int x, int z) const { return topSolid[index(x, z)]; }
+    int getTopOpaque(int x, int z) const { return topOpaque[index(x, z)]; }
+
+    void setColumn(int x, int z, int solid, int opaque)
+    {
+        topSolid[index(x, z)] = static_cast<int16_t>(solid);
+        topOpaque[index(x, z)] = static_cast<int16_t>(opaque);
+    }
+
+    int getMaxSolid() const { return *std::max_element(topSolid.begin(), topSolid.end()); }
+    int getMinSolid() const { return *std::min_element(topSolid.begin(), topSolid.end()); }
+    int getMinOpaque() const { return *std::min_element(topOpaque.begin(), topOpaque.end()); }
+
+    static int index(int x, int z) { return z * SIZE + x; }
+};
+
+#endif // HEIGHTMAP_H
@@ -5,15 +5,25 @@
 #include <random>
 #include <cmath>
 #include <numeric>
+#include <utility>
 
 class PerlinNoise {
 public:
     PerlinNoise(unsigned int seed = 1298) {
-        // Initialize permutation vector
+        reseed(seed);
+    }
+
+    // Rebuilds the permutation table. std::mt19937 and the hand-rolled shuffle are
+    // fully specified by the standard, so a seed gives the same terrain on every
+    // compiler and platform (std::shuffle and default_random_engine are not).
+    void reseed(unsigned int seed) {
         p.resize(256);
         std::iota(p.begin(), p.end(), 0);
-        std::default_random_engine engine(seed);
-        std::shuffle(p.begin(), p.end(), engine);
+        std::mt19937 engine(seed);
+        for (int i = 255; i > 0; i--) {
+            int j = static_cast<int>(engine() % static_cast<unsigned int>(i + 1));
+            std::swap(p[i], p[j]);
+        }
         p.insert(p.end(), p.begin(), p.end());
     }
 
@@ -0,0 +1,102 @@
+#ifndef SECTION_VISIBILITY_H
+#define SECTION_VISIBILITY_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Faces of a 16x16x16 chunk section; a face and its opposite differ only in the low bit
+enum SectionFace
+{
+    SECTION_FACE_NEG_X = 0,
+    SECTION_FACE_POS_X,
+    SECTION_FACE_NEG_Y,
+    SECTION_FACE_POS_Y,
+    SECTION_FACE_NEG_Z,
+    SECTION_FACE_POS_Z,
+    SECTION_FACE_COUNT
+};
+
+inline int oppositeFace(int face) { return face ^ 1; }
+
+inline glm::ivec3 faceDirection(int face)
+{
+    static const std::array<glm::ivec3, SECTION_FACE_COUNT> directions = {
+        glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+        glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+        glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)};
+    return directions[face];
+}
+
+// Which pairs of section faces are joined by a path through non-opaque blocks.
+// Defaults to fully connected, which is always a safe answer.
+struct SectionVisibility
+{
+    static const int SIZE = 16;
+
+    uint64_t connections = ALL_CONNECTED;
+
+    bool canSee(int from, int to) const { return (connections >> (from * SECTION_FACE_COUNT + to)) & 1; }
+
+    void connect(int a, int b)
+    {
+        connections |= uint64_t(1) << (a * SECTION_FACE_COUNT + b);
+        connections |= uint64_t(1) << (b * SECTION_FACE_COUNT + a);
+    }
+
+    // Flood fills the section's open cells; every face touched by one open region
+    // can see every other face touched by it. isOpaque(x, y, z) takes local coordinates.
+    template <typename IsOpaque>
+    void compute(IsOpaque &&isOpaque)
+    {
+        connections = 0;
+        std::vector<uint8_t> visited(SIZE * SIZE * SIZE, 0);
+        std::vector<int> stack;
+        stack.reserve(SIZE * SIZE * SIZE);
+
+        for (int start = 0; start < SIZE * SIZE * SIZE; start++)
+        {
+            if (visited[start])
+                continue;
+            visited[start] = 1;
+            if (isOpaque(start % SIZE, start / (SIZE * SIZE), (start / SIZE) % SIZE))
+                continue;
+
+            unsigned int touched = 0;
+            stack.push_back(start);
+            while (!stack.empty())
+            {
+                int cell = stack.back();
+                stack.pop_back();
+                glm::ivec3 pos(cell % SIZE, cell / (SIZE * SIZE), (cell / SIZE) % SIZE);
+
+                for (int face = 0; face < SECTION_FACE_COUNT; face++)
+                {
+                    glm::ivec3 next = pos + faceDirection(face);
+                    if (next.x < 0 || next.x >= SIZE || next.y < 0 || next.y >= SIZE || next.z < 0 || next.z >= SIZE)
+                    {
+                        touched |= 1u << face;
+                        continue;
+                    }
+                    int index = (next.y * SIZE + next.z) * SIZE + next.x;
+                    if (visited[index])
+                        continue;
+                    visited[index] = 1;
+                    if (!isOpaque(next.x, next.y, next.z))
+                        stack.push_back(index);
+                }
+            }
+
+            for (int a = 0; a < SECTION_FACE_COUNT; a++)
+                for (int b = 0; b < SECTION_FACE_COUNT; b++)
+                    if ((touched & (1u << a)) && (touched & (1u << b)))
+                        connect(a, b);
+        }
+    }
+
+private:
+    static const uint64_t ALL_CONNECTED = (uint64_t(1) << (SECTION_FACE_COUNT * SECTION_FACE_COUNT)) - 1;
+};
+
+#endif // SECTION_VISIBILITY_H
@@ -4,10 +4,19 @@
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
 #include "worldGenerator.h"
 #include "../object.h"
+#include "../Math/frustrum.h"
 #include "../Util/AABB.h"
+#include "../Util/parallel.h"
+#include "../Util/lruCache.h"
 
 // Chunk grid coordinate hasher
 struct ChunkCoordHash
@@ -27,6 +36,30 @@ struct BlockRaycastHit
     std::shared_ptr<Chunk> chunk;
 };
 
+// Called as chunks finish during a bulk bake: (chunks done, chunks total)
+using TerrainProgressCallback = std::function<void(int done, int total)>;
+
+// Chunk distance (to its center, in blocks) where each coarser mesh level takes over
+struct WorldLodParams
+{
+    std::array<float, Chunk::LOD_COUNT - 1> distances{128.0f, 256.0f, 512.0f};
+    // A chunk has to move this far past a threshold before it switches, so
+    // a viewer standing on a boundary doesn't keep regenerating it
+    float hysteresis = 16.0f;
+
+    int selectLod(float distance, int currentLod = -1) const
+    {
+        int lod = 0;
+        while (lod < Chunk::LOD_COUNT - 1 && distance >= distances[lod])
+            lod++;
+        if (currentLod < 0 || lod == currentLod)
+            return lod;
+        // Only switch once the distance is clear of the shared threshold
+        float threshold = distances[std::min(lod, currentLod)];
+        return std::abs(distance - threshold) < hysteresis ? currentLod : lod;
+    }
+};
+
 class World
 {
 public:
@@ -34,8 +67,15 @@ public:
     {
         root = std::make_shared<Object>("World");
     }
+    // headless worlds hold block data only and never build meshes (see WorldGenerator::setHeadless)
+    World(const WorldGeneratorParams &params, bool headless = false) : worldGen(params)
+    {
+        worldGen.setHeadless(headless);
+        root = std::make_shared<Object>("World");
+    }
     ~World()
     {
+        stopStreaming();
         for (auto &chunk : chunks)
         {
             chunk.second.reset();
@@ -44,19 +84,268 @@ public:
         root.reset();
     }
 
-    void requestChunk(int gridX, int gridZ)
+    // Queues a chunk for generation at the given level of detail. A loaded chunk at
+    // another level is replaced once the new one is ready.
+    void requestChunk(int gridX, int gridZ, int lod = 0)
     {
         glm::ivec2 coords(gridX, gridZ);
 
         // Check if chunk already exists or is queued
-        if (chunks.find(coords) != chunks.end() ||
-            std::find(chunkRequests.begin(), chunkRequests.end(), coords) != chunkRequests.end())
+        auto loaded = chunks.find(coords);
+        if (loaded != chunks.end() && loaded->second->getLod() == lod)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            auto pending = pendingLods.find(coords);
+            if (pending != pendingLods.end())
+            {
+                // Still queued or generating; whatever comes out is re-checked by the streamer
+                pending->second = lod;
+                return;
+            }
+            pendingLods[coords] = lod;
+            chunkRequests.push_back(coords);
+            requestsAdded = true;
+        }
+        requestCV.notify_one();
+    }
+
+    // Requests every missing chunk whose center lies within radius blocks of center, nearest
+    // first, each at the level of detail its distance calls for
+    void requestArea(const glm::vec3 &center, float radius)
+    {
+        int centerGridX = static_cast<int>(std::floor(center.x / Chunk::CHUNK_SIZE));
+        int centerGridZ = static_cast<int>(std::floor(center.z / Chunk::CHUNK_SIZE));
+        int gridRadius = static_cast<int>(std::ceil(radius / Chunk::CHUNK_SIZE));
+
+        std::vector<std::pair<float, glm::ivec2>> area;
+        for (int x = centerGridX - gridRadius; x <= centerGridX + gridRadius; x++)
         {
+            for (int z = centerGridZ - gridRadius; z <= centerGridZ + gridRadius; z++)
+            {
+                glm::vec2 chunkCenter((x + 0.5f) * Chunk::CHUNK_SIZE, (z + 0.5f) * Chunk::CHUNK_SIZE);
+                float distance = glm::length(glm::vec2(center.x, center.z) - chunkCenter);
+                if (distance <= radius && chunks.find(glm::ivec2(x, z)) == chunks.end())
+                    area.emplace_back(distance, glm::ivec2(x, z));
+            }
+        }
+        std::sort(area.begin(), area.end(), [](const auto &a, const auto &b)
+                  { return a.first < b.first; });
+        for (const auto &entry : area)
+            requestChunk(entry.second.x, entry.second.y, lodParams.selectLod(entry.first));
+    }
+
+    // Keeps the loaded area following the viewer: requests chunks that came into range,
+    // swaps chunks to the level of detail their distance calls for and unloads chunks that
+    // went out of range. Edited chunks are never regenerated, so they stay at full detail.
+    // Rescans only after the viewer has moved a little.
+    void updateStreaming(const glm::vec3 &viewer, float radius)
+    {
+        glm::vec2 position(viewer.x, viewer.z);
+        if (hasStreamedFrom && glm::length(position - lastStreamPosition) < STREAM_RESCAN_DISTANCE &&
+            radius == lastStreamRadius)
             return;
+        hasStreamedFrom = true;
+        lastStreamPosition = position;
+        lastStreamRadius = radius;
+
+        auto distanceTo = [&](const glm::ivec2 &coords)
+        {
+            glm::vec2 chunkCenter((coords.x + 0.5f) * Chunk::CHUNK_SIZE, (coords.y + 0.5f) * Chunk::CHUNK_SIZE);
+            return glm::length(position - chunkCenter);
+        };
+
+        // Out of range, with some slack so chunks on the edge don't flicker in and out
+        for (auto it = chunks.begin(); it != chunks.end();)
+        {
+            if (!it->second->isModified() && distanceTo(it->first) > radius + lodParams.hysteresis)
+            {
+                it->second->SetParent(nullptr);
+                it = chunks.erase(it);
+            }
+            else
+            {
+                it++;
+            }
         }
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            for (auto it = chunkRequests.begin(); it != chunkRequests.end();)
+            {
+                if (distanceTo(*it) > radius + lodParams.hysteresis)
+                {
+                    pendingLods.erase(*it);
+                    it = chunkRequests.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+
+        // Loaded chunks that now want another level; the old mesh stays up until the new one lands
+        for (const auto &[coords, chunk] : chunks)
+        {
+            if (chunk->isModified())
+                continue;
+            int lod = lodParams.selectLod(distanceTo(coords), chunk->getLod());
+            if (lod != chunk->getLod())
+                requestChunk(coords.x, coords.y, lod);
+        }
+        requestArea(viewer, radius);
+    }
 
-        chunkRequests.push_back(coords);
+    void setLodParams(const WorldLodParams &params)
+    {
+        lodParams = params;
+        hasStreamedFrom = false;
     }
+    const WorldLodParams &getLodParams() const { return lodParams; }
+
+    // Reorders queued requests so the chunk under the viewer goes first, then chunks
+    // inside the view frustum, then everything else; nearest first within each group.
+    // Only the next PRIORITY_SLICE requests are put in order, and only once the viewer
+    // enters another chunk, new requests arrive or the workers have taken that slice,
+    // so turning on the spot reaches the queue as the slice drains.
+    void prioritizeRequests(const glm::vec3 &viewer, const Frustum &frustum)
+    {
+        glm::ivec2 viewerChunk(
+            static_cast<int>(std::floor(viewer.x / Chunk::CHUNK_SIZE)),
+            static_cast<int>(std::floor(viewer.z / Chunk::CHUNK_SIZE)));
+        const float halfSize = Chunk::CHUNK_SIZE / 2.0f;
+        const float boundingRadius = glm::length(glm::vec3(halfSize, Chunk::CHUNK_HEIGHT / 2.0f, halfSize));
+
+        auto priority = [&](const glm::ivec2 &coords)
+        {
+            glm::vec3 chunkCenter((coords.x + 0.5f) * Chunk::CHUNK_SIZE, Chunk::CHUNK_HEIGHT / 2.0f,
+                                  (coords.y + 0.5f) * Chunk::CHUNK_SIZE);
+            float distance = glm::length(glm::vec2(viewer.x - chunkCenter.x, viewer.z - chunkCenter.z));
+            int group = coords == viewerChunk ? 0 : frustum.isInFrustum(chunkCenter, boundingRadius) ? 1 : 2;
+            return std::make_pair(group, distance);
+        };
+
+        std::lock_guard<std::mutex> lock(requestMutex);
+        bool moved = !hasPrioritized || viewerChunk != prioritizedChunk;
+        if (!moved && !requestsAdded && chunkRequests.size() > prioritizedTail)
+            return;
+        hasPrioritized = true;
+        prioritizedChunk = viewerChunk;
+        requestsAdded = false;
+        prioritizedTail = 0;
+        if (chunkRequests.size() < 2)
+            return;
+
+        auto &keyed = prioritizeScratch;
+        keyed.clear();
+        for (const auto &coords : chunkRequests)
+            keyed.emplace_back(priority(coords), coords);
+        auto byPriority = [](const auto &a, const auto &b)
+        { return a.first < b.first; };
+        std::size_t slice = std::min(PRIORITY_SLICE, keyed.size());
+        std::nth_element(keyed.begin(), keyed.begin() + (slice - 1), keyed.end(), byPriority);
+        std::sort(keyed.begin(), keyed.begin() + slice, byPriority);
+        for (std::size_t i = 0; i < keyed.size(); i++)
+            chunkRequests[i] = keyed[i].second;
+        prioritizedTail = keyed.size() - slice;
+    }
+
+    // Starts background generation threads that drain the request queue.
+    // Finished chunks are attached to the world by tickUpdate on the main thread.
+    void startStreaming(unsigned int threads = 0)
+    {
+        if (!streamWorkers.empty())
+            return;
+        if (threads == 0)
+            threads = std::max(1u, getWorkerCount() - 1); // Leave a core for the render thread
+        stopRequested.store(false);
+        for (unsigned int i = 0; i < threads; i++)
+            streamWorkers.emplace_back([this, i]()
+                                       {
+                                           TraceRecorder::setThreadName("Stream worker " + std::to_string(i + 1));
+                                           streamWorker(); });
+    }
+
+    void stopStreaming()
+    {
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            stopRequested.store(true);
+        }
+        requestCV.notify_all();
+        for (auto &worker : streamWorkers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+        streamWorkers.clear();
+    }
+
+    bool isStreaming() const { return !streamWorkers.empty(); }
+    std::size_t getStreamingThreadCount() const { return streamWorkers.size(); }
+
+    // Replaces the streaming threads; chunks they're generating finish first
+    void restartStreaming(unsigned int threads)
+    {
+        stopStreaming();
+        startStreaming(threads);
+    }
+
+    // Chunks requested but not yet attached to the world (queued, generating or finished)
+    std::size_t getPendingChunkCount() const
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        return pendingLods.size();
+    }
+
+    // Copies the heightmap of a chunk. Loaded chunks report their live heightmap;
+    // anywhere else the generator's prediction is used and cached.
+    void getHeightmap(int gridX, int gridZ, ChunkHeightmap &out)
+    {
+        if (auto chunk = getChunk(gridX, gridZ))
+        {
+            out = chunk->getHeightmap();
+            return;
+        }
+
+        glm::ivec2 coords(gridX, gridZ);
+        std::lock_guard<std::mutex> lock(heightmapMutex);
+        if (auto *cached = predictedHeightmaps.get(coords))
+        {
+            out = *cached;
+            return;
+        }
+        worldGen.generateHeightmap(gridX * Chunk::CHUNK_SIZE, gridZ * Chunk::CHUNK_SIZE, out);
+        predictedHeightmaps.put(coords, out);
+    }
+
+    // Y of the top solid (or opaque) block in a world column, or ChunkHeightmap::NO_BLOCK
+    int getSurfaceHeight(int worldX, int worldZ, bool opaque = false)
+    {
+        int gridX = static_cast<int>(std::floor(float(worldX) / Chunk::CHUNK_SIZE));
+        int gridZ = static_cast<int>(std::floor(float(worldZ) / Chunk::CHUNK_SIZE));
+        int localX = worldX - gridX * Chunk::CHUNK_SIZE;
+        int localZ = worldZ - gridZ * Chunk::CHUNK_SIZE;
+
+        if (auto chunk = getChunk(gridX, gridZ))
+        {
+            const auto &heightmap = chunk->getHeightmap();
+            return opaque ? heightmap.getTopOpaque(localX, localZ) : heightmap.getTopSolid(localX, localZ);
+        }
+
+        ChunkHeightmap heightmap;
+        getHeightmap(gridX, gridZ, heightmap);
+        return opaque ? heightmap.getTopOpaque(localX, localZ) : heightmap.getTopSolid(localX, localZ);
+    }
+
+    std::size_t getLoadedChunkCount() const { return chunks.size(); }
+    // Requested chunks no worker has picked up yet
+    std::size_t getQueuedChunkCount() const
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        return chunkRequests.size();
+    }
+    int getGeneratingChunkCount() const { return chunksInGeneration.load(); }
 
     std::shared_ptr<Chunk> getChunk(int gridX, int gridZ) const
     {
@@ -158,7 +447,11 @@ public:
         return false;
     }
 
-    void generateTerrain(int width = 10, int depth = 10)
+    // Generates and meshes a width x depth block of chunks centered on the origin.
+    // Chunks are built across all worker threads; each one only depends on its
+    // own coordinates and they are attached to the world in grid order afterwards,
+    // so the result is identical for any thread count.
+    void generateTerrain(int width = 10, int depth = 10, const TerrainProgressCallback &onProgress = nullptr)
     {
         // Calculate grid coordinates to center around origin (0,0,0)
         int halfWidth = width / 2;
@@ -174,95 +467,93 @@ public:
         {
             for (int z = 0; z < depth; z++)
             {
-                int gridX = startX + x;
-                int gridZ = startZ + z;
-                coordsToRequest.emplace_back(gridX, gridZ);
+                glm::ivec2 coords(startX + x, startZ + z);
+                if (chunks.find(coords) != chunks.end())
+                    continue;
+                std::lock_guard<std::mutex> lock(requestMutex);
+                if (pendingLods.find(coords) != pendingLods.end())
+                    continue;
+                coordsToRequest.push_back(coords);
             }
         }
 
-        for (const auto &coords : coordsToRequest)
-        {
-            if (chunks.find(coords) != chunks.end() ||
-                std::find(chunkRequests.begin(), chunkRequests.end(), coords) != chunkRequests.end())
+        // Fork: generate unparented chunks in parallel, one output slot per coordinate
+        std::vector<std::shared_ptr<Chunk>> generated(coordsToRequest.size());
+        parallelFor(
+            coordsToRequest.size(),
+            [&](std::size_t i)
             {
-                continue;
-            }
-            int worldX = coords.x * Chunk::CHUNK_SIZE;
-            int worldZ = coords.y * Chunk::CHUNK_SIZE;
-            auto chunk = worldGen.generateChunk(root, worldX, worldZ, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE);
-            chunks[coords] = chunk;
-            // requestChunk(coords.x, coords.y);
+                int worldX = coordsToRequest[i].x * Chunk::CHUNK_SIZE;
+                int worldZ = coordsToRequest[i].y * Chunk::CHUNK_SIZE;
+                generated[i] = worldGen.generateChunk(nullptr, worldX, worldZ, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE);
+            },
+            workerCount,
+            [&](std::size_t done, std::size_t total)
+            {
+                if (onProgress)
+                    onProgress(static_cast<int>(done), static_cast<int>(total));
+            });
+
+        // Join: the object hierarchy isn't thread safe, so parent on this thread in order
+        for (std::size_t i = 0; i < coordsToRequest.size(); i++)
+        {
+            generated[i]->SetParent(root);
+            chunks[coordsToRequest[i]] = generated[i];
         }
     }
 
+    // Threads used for bulk generation; 0 picks one per hardware thread
+    void setWorkerCount(unsigned int count) { workerCount = count; }
+    unsigned int getWorkerCount() const { return workerCount == 0 ? getDefaultWorkerCount() : workerCount; }
+
+    // Generates every queued chunk synchronously on the calling thread
     void update()
     {
-        while (!chunkRequests.empty() && chunksInGeneration < maxConcurrentGeneration)
+        while (generateNextRequest())
         {
-            glm::ivec2 coords = chunkRequests.front();
-            chunkRequests.pop_front();
-
-            try
-            {
-                // Convert grid coordinates to world coordinates
-                int worldX = coords.x * Chunk::CHUNK_SIZE;
-                int worldZ = coords.y * Chunk::CHUNK_SIZE;
-
-                auto chunk = worldGen.generateChunk(root, worldX, worldZ,
-                                                    Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE);
-
-                chunks[coords] = chunk;
-                chunksInGeneration++;
-                // Add this: Notify when generation complete
-                if (chunksInGeneration == 0)
-                {
-                    generationCV.notify_all();
-                }
-            }
-            catch (...)
-            {
-                // Return coords to queue on failure
-                chunksInGeneration--;
-                chunkRequests.push_front(coords);
-                throw;
-            }
         }
     }
 
     void tickUpdate()
     {
-        if (!chunkRequests.empty() && chunksInGeneration < maxConcurrentGeneration)
+        updateMetrics();
+        if (isStreaming())
         {
-            glm::ivec2 coords = chunkRequests.front();
-            chunkRequests.pop_front();
-
-            try
-            {
-                // Convert grid coordinates to world coordinates
-                int worldX = coords.x * Chunk::CHUNK_SIZE;
-                int worldZ = coords.y * Chunk::CHUNK_SIZE;
-
-                auto chunk = worldGen.generateChunk(root, worldX, worldZ,
-                                                    Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE);
+            integrateCompletedChunks();
+            return;
+        }
+        // Without worker threads, generate one queued chunk per tick
+        generateNextRequest();
+    }
 
-                chunks[coords] = chunk;
-                chunksInGeneration++;
-                // Add this: Notify when generation complete
-                if (chunksInGeneration == 0)
-                {
-                    generationCV.notify_all();
-                }
-            }
-            catch (...)
+    // Main thread. Blocks until every requested chunk is generated, meshed and attached,
+    // so benchmarks see the same loaded area on every run whatever the workers' timing.
+    void finishPendingChunks()
+    {
+        while (getPendingChunkCount() > 0)
+        {
+            if (!isStreaming())
             {
-                // Return coords to queue on failure
-                chunksInGeneration--;
-                chunkRequests.push_front(coords);
-                throw;
+                if (!generateNextRequest())
+                    return;
+                continue;
             }
+            integrateCompletedChunks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     }
 
+    const WorldGenerator &getGenerator() const { return worldGen; }
+
+    // Loaded chunks in grid order (x, then z) so callers get a stable sequence
+    std::vector<std::pair<glm::ivec2, std::shared_ptr<Chunk>>> getLoadedChunks() const
+    {
+        std::vector<std::pair<glm::ivec2, std::shared_ptr<Chunk>>> result(chunks.begin(), chunks.end());
+        std::sort(result.begin(), result.end(), [](const auto &a, const auto &b)
+                  { return a.first.x != b.first.x ? a.first.x < b.first.x : a.first.y < b.first.y; });
+        return result;
+    }
+
     shared_ptr<Object> getRoot() const
     {
         return root;
@@ -303,19 +594,367 @@ public:
         return result;
     }
 
+    // Ready chunks within radius whose occupied bounds touch the frustum,
+    // sorted nearest first so opaque geometry fills the depth buffer front to back.
+    // With section culling on, chunks are also trimmed to the sections the
+    // visibility graph says can be seen from the viewer's section.
+    std::vector<std::shared_ptr<Chunk>> getVisibleChunks(const glm::vec3 &center, float radius, const Frustum &frustum)
+    {
+        auto inRange = getChunksInRange(center, radius);
+
+        cullBounds.clear();
+        cullBounds.reserve(inRange.size());
+        cullCandidates.clear();
+        for (uint32_t i = 0; i < inRange.size(); i++)
+        {
+            glm::vec3 min, max;
+            if (!inRange[i]->getBounds(min, max))
+                continue;
+            cullBounds.add(min, max);
+            cullCandidates.push_back(i);
+        }
+
+        cullVisible.clear();
+        frustum.cullBoxes(cullBounds, cullVisible);
+
+        std::vector<std::pair<float, uint32_t>> sorted;
+        sorted.reserve(cullVisible.size());
+        for (uint32_t box : cullVisible)
+        {
+            glm::vec3 closest = glm::clamp(center,
+                                           glm::vec3(cullBounds.minX[box], cullBounds.minY[box], cullBounds.minZ[box]),
+                                           glm::vec3(cullBounds.maxX[box], cullBounds.maxY[box], cullBounds.maxZ[box]));
+            glm::vec3 offset = closest - center;
+            sorted.emplace_back(glm::dot(offset, offset), cullCandidates[box]);
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        bool trimSections = sectionCulling && findVisibleSections(center, radius, frustum);
+
+        std::vector<std::shared_ptr<Chunk>> result;
+        result.reserve(sorted.size());
+        for (const auto &entry : sorted)
+        {
+            const auto &chunk = inRange[entry.second];
+            glm::ivec2 coords = getGridCoords(chunk->getPosition());
+            // The search stops at the first level of detail change; anything past it is drawn whole
+            if (!trimSections || std::abs(coords.x - sectionSearchCenter.x) > sectionSearchRadius ||
+                std::abs(coords.y - sectionSearchCenter.y) > sectionSearchRadius)
+            {
+                chunk->setVisibleSections(0, Chunk::SECTION_COUNT);
+                result.push_back(chunk);
+                continue;
+            }
+
+            // The search walks through unready columns but never hands them out
+            auto visits = sectionVisits.find(coords);
+            if (visits == sectionVisits.end() || !chunk->isReady())
+                continue;
+            int begin = Chunk::SECTION_COUNT, end = 0;
+            for (int section = 0; section < Chunk::SECTION_COUNT; section++)
+            {
+                if ((visits->second & (1u << section)) && chunk->hasSectionGeometry(section))
+                {
+                    begin = std::min(begin, section);
+                    end = section + 1;
+                }
+            }
+            if (begin >= end)
+                continue;
+            chunk->setVisibleSections(begin, end);
+            result.push_back(chunk);
+        }
+        return result;
+    }
+
+    // Sees every mesh a worker builds, on that worker; the client uses it to stage
+    // meshes for the GPU without waiting for the render thread
+    void setMeshListener(std::shared_ptr<ChunkMeshListener> listener) { worldGen.setMeshListener(listener); }
+
+    void setSectionCulling(bool enabled) { sectionCulling = enabled; }
+    bool isSectionCulling() const { return sectionCulling; }
+
 private:
     shared_ptr<Object> root;
     WorldGenerator worldGen;
 
-    // Chunk grid storage
+    // Chunk grid storage (main thread only)
     std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>, ChunkCoordHash> chunks;
+
+    // Request queue shared with the streaming workers, guarded by requestMutex
+    mutable std::mutex requestMutex;
+    std::condition_variable requestCV;
     std::deque<glm::ivec2> chunkRequests;
+    bool requestsAdded = false; // Since the last prioritizeRequests pass
+    std::unordered_map<glm::ivec2, int, ChunkCoordHash> pendingLods; // Level each pending chunk is built at
+
+    // Chunks finished by workers, waiting to be attached on the main thread
+    std::mutex completedMutex;
+    std::vector<std::pair<glm::ivec2, std::shared_ptr<Chunk>>> completedChunks;
+
+    // Generator-predicted heightmaps for chunks that aren't loaded
+    std::mutex heightmapMutex;
+    LRUCache<glm::ivec2, ChunkHeightmap, ChunkCoordHash> predictedHeightmaps{256};
 
     // Generation control
     std::atomic<int> chunksInGeneration{0}; // Make atomic
-    std::condition_variable generationCV;
-    const int maxConcurrentGeneration = 4;
-    bool isGenerationComplete = false;
+    std::vector<std::thread> streamWorkers;
+    // Where the current utilization sample started (main thread only)
+    std::uint64_t utilizationSince = 0;
+    std::uint64_t utilizationBusyNs = 0;
+    std::atomic<bool> stopRequested{false};
+    unsigned int workerCount = 0;
+
+    // Streaming state (main thread only)
+    static constexpr float STREAM_RESCAN_DISTANCE = 8.0f;
+    WorldLodParams lodParams;
+    bool hasStreamedFrom = false;
+    glm::vec2 lastStreamPosition{0.0f};
+    float lastStreamRadius = 0.0f;
+
+    // Request ordering, guarded by requestMutex
+    static constexpr std::size_t PRIORITY_SLICE = 256; // Requests put in order per pass
+    bool hasPrioritized = false;
+    glm::ivec2 prioritizedChunk{0};
+    std::size_t prioritizedTail = 0; // Unordered requests behind the slice; fewer means it's been taken
+    std::vector<std::pair<std::pair<int, float>, glm::ivec2>> prioritizeScratch;
+
+    // Scratch space reused by getVisibleChunks (main thread only)
+    FrustumBoxList cullBounds;
+    std::vector<uint32_t> cullCandidates;
+    std::vector<uint32_t> cullVisible;
+
+    // Section visibility search state, also main thread only
+    struct SectionStep
+    {
+        glm::ivec2 coords;
+        const Chunk *chunk; // Null while the column hasn't streamed in yet
+        int section;
+        int entryFace;      // Face the search came in through, -1 for the viewer's section
+        uint8_t directions; // Every direction stepped so far; the search never turns back
+    };
+    bool sectionCulling = true;
+    std::vector<SectionStep> sectionQueue;
+    std::unordered_map<glm::ivec2, uint16_t, ChunkCoordHash> sectionVisits; // Bit per reachable section
+    glm::ivec2 sectionSearchCenter{0};
+    int sectionSearchRadius = 0; // In chunks; the search covers full-detail chunks only
+
+    static glm::ivec2 getGridCoords(const glm::vec3 &position)
+    {
+        return glm::ivec2(static_cast<int>(std::floor(position.x / Chunk::CHUNK_SIZE)),
+                          static_cast<int>(std::floor(position.z / Chunk::CHUNK_SIZE)));
+    }
+
+    // Breadth-first search outward from the viewer's section. A neighbour is entered only
+    // if the current section connects the face we came in through to the face we leave by,
+    // and the neighbour's box is inside the frustum. Columns that aren't loaded or ready
+    // count as open air, so the search carries on past streaming gaps to the chunks behind.
+    // Returns false when the viewer isn't inside a loaded section, in which case nothing
+    // can be ruled out.
+    bool findVisibleSections(const glm::vec3 &viewer, float radius, const Frustum &frustum)
+    {
+        sectionVisits.clear();
+        sectionQueue.clear();
+
+        glm::ivec2 startCoords = getGridCoords(viewer);
+        int startSection = static_cast<int>(std::floor(viewer.y / SectionVisibility::SIZE));
+        auto start = chunks.find(startCoords);
+        if (startSection < 0 || startSection >= Chunk::SECTION_COUNT ||
+            start == chunks.end() || !start->second->isReady())
+            return false;
+
+        // Coarse chunks don't keep the blocks their section graphs would come from
+        float searchRadius = std::min(radius, lodParams.distances[0]);
+        int gridRadius = static_cast<int>(std::floor(searchRadius / Chunk::CHUNK_SIZE));
+        sectionSearchCenter = startCoords;
+        sectionSearchRadius = gridRadius;
+        sectionVisits[startCoords] = static_cast<uint16_t>(1u << startSection);
+        sectionQueue.push_back({startCoords, start->second.get(), startSection, -1, 0});
+
+        for (size_t head = 0; head < sectionQueue.size(); head++)
+        {
+            static const SectionVisibility OPEN_SECTION;
+            SectionStep step = sectionQueue[head];
+            const SectionVisibility &visibility = step.chunk ? step.chunk->getSectionVisibility(step.section) : OPEN_SECTION;
+
+            for (int face = 0; face < SECTION_FACE_COUNT; face++)
+            {
+                if (step.directions & (1u << oppositeFace(face)))
+                    continue;
+                if (step.entryFace >= 0 && !visibility.canSee(step.entryFace, face))
+                    continue;
+
+                glm::ivec3 direction = faceDirection(face);
+                int section = step.section + direction.y;
+                glm::ivec2 coords = step.coords + glm::ivec2(direction.x, direction.z);
+                if (section < 0 || section >= Chunk::SECTION_COUNT ||
+                    std::abs(coords.x - startCoords.x) > gridRadius || std::abs(coords.y - startCoords.y) > gridRadius)
+                    continue;
+
+                const Chunk *chunk = step.chunk;
+                if (coords != step.coords)
+                {
+                    auto it = chunks.find(coords);
+                    chunk = it != chunks.end() && it->second->isReady() ? it->second.get() : nullptr;
+                }
+
+                uint16_t &visited = sectionVisits[coords];
+                if (visited & (1u << section))
+                    continue;
+
+                glm::vec3 min(coords.x * Chunk::CHUNK_SIZE, section * SectionVisibility::SIZE, coords.y * Chunk::CHUNK_SIZE);
+                if (!frustum.isBoxInFrustum(min, min + glm::vec3(SectionVisibility::SIZE)))
+                    continue;
+
+                visited |= static_cast<uint16_t>(1u << section);
+                sectionQueue.push_back({coords, chunk, section, oppositeFace(face),
+                                        static_cast<uint8_t>(step.directions | (1u << face))});
+            }
+        }
+        return true;
+    }
+
+    std::shared_ptr<Chunk> generateAt(const glm::ivec2 &coords, int lod)
+    {
+        // Convert grid coordinates to world coordinates
+        int worldX = coords.x * Chunk::CHUNK_SIZE;
+        int worldZ = coords.y * Chunk::CHUNK_SIZE;
+        return worldGen.generateChunk(nullptr, worldX, worldZ, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE, lod);
+    }
+
+    // Main thread. Puts a finished chunk in its slot, detaching the chunk it replaces.
+    void attachChunk(const glm::ivec2 &coords, const std::shared_ptr<Chunk> &chunk)
+    {
+        auto &slot = chunks[coords];
+        if (slot)
+        {
+            // Never throw away edits for a level of detail change that was queued before them
+            if (slot->isModified())
+                return;
+            slot->SetParent(nullptr);
+        }
+        chunk->SetParent(root);
+        slot = chunk;
+    }
+
+    bool generateNextRequest()
+    {
+        glm::ivec2 coords;
+        int lod;
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            if (chunkRequests.empty())
+                return false;
+            coords = chunkRequests.front();
+            chunkRequests.pop_front();
+            lod = pendingLods[coords];
+        }
+
+        try
+        {
+            attachChunk(coords, generateAt(coords, lod));
+        }
+        catch (...)
+        {
+            // Return coords to queue on failure
+            std::lock_guard<std::mutex> lock(requestMutex);
+            chunkRequests.push_front(coords);
+            throw;
+        }
+        std::lock_guard<std::mutex> lock(requestMutex);
+        pendingLods.erase(coords);
+        return true;
+    }
+
+    void streamWorker()
+    {
+        while (true)
+        {
+            glm::ivec2 coords;
+            int lod;
+            {
+                std::unique_lock<std::mutex> lock(requestMutex);
+                requestCV.wait(lock, [this]()
+                               { return stopRequested.load() || !chunkRequests.empty(); });
+                if (stopRequested.load())
+                    return;
+                coords = chunkRequests.front();
+                chunkRequests.pop_front();
+                lod = pendingLods[coords];
+                chunksInGeneration++;
+            }
+
+            try
+            {
+                static MetricCounter &busy = Metrics::counter("streaming.busy_ns");
+                static MetricHistogram &generateTime = Metrics::histogram("streaming.generate_us");
+                std::uint64_t start = Metrics::now();
+                auto chunk = generateAt(coords, lod);
+                std::uint64_t elapsed = Metrics::now() - start;
+                busy.add(elapsed);
+                generateTime.record(elapsed / 1000);
+                std::lock_guard<std::mutex> lock(completedMutex);
+                completedChunks.emplace_back(coords, chunk);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Chunk generation failed at " << coords.x << ", " << coords.y << ": " << e.what() << std::endl;
+                std::lock_guard<std::mutex> lock(requestMutex);
+                pendingLods.erase(coords); // Allow it to be requested again
+            }
+            chunksInGeneration--;
+        }
+    }
+
+    // Main thread. Queue depths every tick; worker utilization about once a second,
+    // as the share of the workers' time spent generating
+    void updateMetrics()
+    {
+        static MetricGauge &loaded = Metrics::gauge("world.loaded_chunks");
+        static MetricGauge &queued = Metrics::gauge("streaming.queued");
+        static MetricGauge &generating = Metrics::gauge("streaming.generating");
+        static MetricGauge &completed = Metrics::gauge("streaming.completed");
+        static MetricGauge &workers = Metrics::gauge("streaming.workers");
+        static MetricGauge &utilization = Metrics::gauge("streaming.utilization_pct");
+        static MetricCounter &busy = Metrics::counter("streaming.busy_ns");
+        loaded.set(static_cast<std::int64_t>(chunks.size()));
+        queued.set(static_cast<std::int64_t>(getQueuedChunkCount()));
+        generating.set(chunksInGeneration.load());
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            completed.set(static_cast<std::int64_t>(completedChunks.size()));
+        }
+        workers.set(static_cast<std::int64_t>(streamWorkers.size()));
+
+        std::uint64_t now = Metrics::now();
+        std::uint64_t busyNs = busy.get();
+        if (utilizationSince == 0 || now - utilizationSince >= 1000000000)
+        {
+            std::uint64_t capacity = (now - utilizationSince) * streamWorkers.size();
+            // Chunks count when they finish, so one spanning two samples can push a sample past 100
+            if (utilizationSince != 0 && capacity > 0)
+                utilization.set(static_cast<std::int64_t>(std::min<std::uint64_t>((busyNs - utilizationBusyNs) * 100 / capacity, 100)));
+            utilizationSince = now;
+            utilizationBusyNs = busyNs;
+        }
+    }
+
+    void integrateCompletedChunks()
+    {
+        std::vector<std::pair<glm::ivec2, std::shared_ptr<Chunk>>> finished;
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            finished.swap(completedChunks);
+        }
+        if (finished.empty())
+            return;
+
+        for (auto &[coords, chunk] : finished)
+            attachChunk(coords, chunk);
+        std::lock_guard<std::mutex> lock(requestMutex);
+        for (const auto &entry : finished)
+            pendingLods.erase(entry.first);
+    }
 };
 
 #endif
\ No newline at end of file
@@ -6,14 +6,18 @@
 #include <cmath>
 #include "../object.h"
 #include "../Block/block.h"
-#include "../assets.h"
 #include "chunk.h"
 #include "perlinNoise.h"
-
-extern AssetManager &assetMgr;
+#include "biomeMap.h"
+#include "../Debug/traceRecorder.h"
+#include "../Debug/metrics.h"
+#include "../Debug/allocationTracker.h"
 
 struct WorldGeneratorParams
 {
+    // World seed; every noise layer derives its own seed from it
+    unsigned int seed = 1298;
+
     // Base terrain
     int octaves = 4;
     float basePersistence = 0.9f;
@@ -29,6 +33,7 @@ struct WorldGeneratorParams
     // Biome
     float biomeScale = 0.004f;
     float biomeBlend = 0.5f; // Not used yet, for future
+    int biomeResolution = 4; // Blocks between cached biome samples
 
     // Overall
     float minHeight = 4.0f;
@@ -39,14 +44,44 @@ class WorldGenerator
 {
 public:
     WorldGenerator(WorldGeneratorParams params)
-        : baseNoise(1298), mountainNoise(4321), riverNoise(9876), biomeNoise(2468)
+        : baseNoise(deriveSeed(params.seed, 0)), mountainNoise(deriveSeed(params.seed, 1)),
+          riverNoise(deriveSeed(params.seed, 2)), biomeNoise(deriveSeed(params.seed, 3)),
+          biomeMap(biomeNoise, params.biomeScale, params.biomeResolution)
     {
         this->params = params;
     }
     WorldGenerator() : WorldGenerator(WorldGeneratorParams()) {}
 
+    // The biome map holds a reference to biomeNoise, so generators stay put
+    WorldGenerator(const WorldGenerator &) = delete;
+    WorldGenerator &operator=(const WorldGenerator &) = delete;
+
     WorldGeneratorParams getParams() const { return params; }
-    void setParams(const WorldGeneratorParams &newParams) { params = newParams; }
+    void setParams(const WorldGeneratorParams &newParams)
+    {
+        if (newParams.seed != params.seed)
+        {
+            baseNoise.reseed(deriveSeed(newParams.seed, 0));
+            mountainNoise.reseed(deriveSeed(newParams.seed, 1));
+            riverNoise.reseed(deriveSeed(newParams.seed, 2));
+            biomeNoise.reseed(deriveSeed(newParams.seed, 3));
+        }
+        params = newParams;
+        biomeMap.configure(params.biomeScale, params.biomeResolution);
+    }
+
+    unsigned int getSeed() const { return params.seed; }
+
+    // Headless generators build block data only and skip meshing.
+    // Used where nothing draws the terrain (pre-generation, servers).
+    void setHeadless(bool enable) { headless = enable; }
+    bool isHeadless() const { return headless; }
+
+    // Sees the meshes built by generateChunk on the worker that built them.
+    // Set before streaming starts; workers only read it.
+    void setMeshListener(std::shared_ptr<ChunkMeshListener> listener) { meshListener = listener; }
+
+    const BiomeMap &getBiomeMap() const { return biomeMap; }
 
     // Get the world position of a block in the terrain
     glm::vec3 getTerrainPosition(int x, int z, float y = 0.0f) const
@@ -61,10 +96,12 @@ public:
 
     float generateHeight(int x, int z) const
     {
-        // --- Biome noise ---
-        float biome = biomeNoise.noise(x * params.biomeScale, 0, z * params.biomeScale);
-        biome = glm::clamp(biome, 0.0f, 1.0f); // Normalize if needed
+        return generateHeight(x, z, biomeMap.sample(x, z));
+    }
 
+    // Height for a column whose biome value was already looked up
+    float generateHeight(int x, int z, float biome) const
+    {
         // --- Base terrain ---
         float base = 0;
         float frequency = 1;
@@ -97,12 +134,22 @@ public:
         return std::round(height);
     }
 
-    std::shared_ptr<Chunk> generateChunk(std::shared_ptr<Object> parent, int chunkX, int chunkZ, int width, int depth)
+    // `lod` picks the mesh detail (see Chunk::setLod); coarse chunks keep no block data
+    std::shared_ptr<Chunk> generateChunk(std::shared_ptr<Object> parent, int chunkX, int chunkZ, int width, int depth, int lod = 0)
     {
+        VOXELC_TRACE_SCOPE("generateChunk", "world");
+        AllocationScope allocations(ALLOC_WORLD);
+        static MetricCounter &generated = Metrics::counter("chunks.generated");
         auto chunk = std::make_shared<Chunk>("Chunk_" + std::to_string(chunkX) + "_" + std::to_string(chunkZ));
         chunk->SetParent(parent);
         chunk->setPosition(glm::vec3(chunkX, 0.0f, chunkZ));
         chunk->setState(ChunkState::GENERATING);
+        chunk->setLod(lod);
+
+        // Biome values for the whole chunk come from the shared map once,
+        // then feed both the height and the surface stage
+        std::vector<float> biomes(width * depth);
+        biomeMap.sampleArea(chunkX, chunkZ, width, depth, biomes.data());
 
         // Generate terrain for each block in the chunk
         for (int x = 0; x < width; x++)
@@ -111,44 +158,88 @@ public:
             {
                 int worldX = chunkX + x;
                 int worldZ = chunkZ + z;
-                float height = generateHeight(worldX, worldZ);
+                float biome = biomes[z * width + x];
+                float height = generateHeight(worldX, worldZ, biome);
 
                 // Generate column of blocks
                 for (int y = 0; y <= height; y++)
                 {
-                    BlockType type;
-                    if (y == static_cast<int>(height))
-                    {
-                        type = BLOCK_TYPE_GRASS; // Top layer
-                    }
-                    else if (y > height - 4)
-                    {
-                        type = BLOCK_TYPE_DIRT; // Few layers of dirt
-                    }
-                    else
-                    {
-                        type = BLOCK_TYPE_STONE; // Stone base
-                    }
-
                     // Set block in local chunk coordinates
-                    chunk->setBlock(x, y, z, type);
+                    chunk->setBlock(x, y, z, getSurfaceBlock(y, height, biome), false);
                 }
+
+                // Every generated block is solid and opaque, so the column top is the height itself
+                int top = static_cast<int>(height);
+                chunk->setHeightmapColumn(x, z, top, top);
             }
         }
 
+        // Freshly generated terrain can always be generated again
+        chunk->setModified(false);
+
         // Force initial mesh update
-        chunk->updateMesh();
+        if (!headless)
+            chunk->updateMesh(meshListener.get());
         chunk->setState(ChunkState::READY);
+        generated.add();
         return chunk;
     }
-    void setParams(WorldGeneratorParams param) { params = param; }
+
+    // Surface heights for a chunk without building its blocks (spawn placement, far terrain, ...)
+    void generateHeightmap(int chunkX, int chunkZ, ChunkHeightmap &out) const
+    {
+        const int size = ChunkHeightmap::SIZE;
+        float biomes[size * size];
+        biomeMap.sampleArea(chunkX, chunkZ, size, size, biomes);
+        for (int z = 0; z < size; z++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                int top = static_cast<int>(generateHeight(chunkX + x, chunkZ + z, biomes[z * size + x]));
+                out.setColumn(x, z, top, top);
+            }
+        }
+    }
+
+    // Top block of a world column and its type, as generateChunk would place it.
+    // Meant for sparse lookups (far terrain), so the biome skips the tile cache.
+    BlockType sampleSurface(int x, int z, int &height) const
+    {
+        float biome = biomeMap.sampleUncached(x, z);
+        float top = generateHeight(x, z, biome);
+        height = static_cast<int>(top);
+        return getSurfaceBlock(height, top, biome);
+    }
+
+    // Block type for layer y of a column; hillier biomes carry a deeper soil layer
+    BlockType getSurfaceBlock(int y, float height, float biome) const
+    {
+        int soilDepth = 3 + static_cast<int>(std::round(biome * 2.0f));
+        if (y == static_cast<int>(height))
+            return BLOCK_TYPE_GRASS; // Top layer
+        if (y > height - (soilDepth + 1))
+            return BLOCK_TYPE_DIRT; // Few layers of dirt
+        return BLOCK_TYPE_STONE;    // Stone base
+    }
 
 private:
     PerlinNoise baseNoise;
     PerlinNoise mountainNoise;
     PerlinNoise riverNoise;
     PerlinNoise biomeNoise;
+    BiomeMap biomeMap;
     WorldGeneratorParams params;
+    bool headless = false;
+    std::shared_ptr<ChunkMeshListener> meshListener;
+
+    // Spreads one world seed into independent per-layer seeds (splitmix32 finalizer)
+    static unsigned int deriveSeed(unsigned int seed, unsigned int layer)
+    {
+        unsigned int h = seed + 0x9E3779B9u * (layer + 1);
+        h = (h ^ (h >> 16)) * 0x85EBCA6Bu;
+        h = (h ^ (h >> 13)) * 0xC2B2AE35u;
+        return h ^ (h >> 16);
+    }
 
     void createBlock(shared_ptr<Object> parent, int x, int z, float height)
     {
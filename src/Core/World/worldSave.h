@@ -0,0 +1,82 @@
+#ifndef WORLD_SAVE_H
+#define WORLD_SAVE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+
+// Region files hold any number of chunks:
+//   "VXCW" | u32 version | u32 seed | u32 chunk count
+//   per chunk: i32 gridX | i32 gridZ | u32 run count | runs of (u8 block type, u16 length)
+// Runs cover the chunk's blocks in storage order (y, then z, then x).
+// Every integer is little-endian so files move between machines.
+namespace WorldSave
+{
+    const char MAGIC[4] = {'V', 'X', 'C', 'W'};
+    const uint32_t VERSION = 1;
+
+    using ChunkEntry = std::pair<glm::ivec2, std::shared_ptr<Chunk>>;
+
+    namespace detail
+    {
+        inline void writeU32(std::ostream &out, uint32_t value)
+        {
+            char bytes[4] = {char(value), char(value >> 8), char(value >> 16), char(value >> 24)};
+            out.write(bytes, 4);
+        }
+        inline void writeU16(std::ostream &out, uint16_t value)
+        {
+            char bytes[2] = {char(value), char(value >> 8)};
+            out.write(bytes, 2);
+        }
+    }
+
+    inline void writeChunk(std::ostream &out, const glm::ivec2 &coords, const Chunk &chunk)
+    {
+        std::vector<std::pair<uint8_t, uint16_t>> runs;
+        for (int y = 0; y < Chunk::CHUNK_HEIGHT; y++)
+        {
+            for (int z = 0; z < Chunk::CHUNK_SIZE; z++)
+            {
+                for (int x = 0; x < Chunk::CHUNK_SIZE; x++)
+                {
+                    uint8_t type = static_cast<uint8_t>(chunk.getBlock(x, y, z));
+                    if (!runs.empty() && runs.back().first == type && runs.back().second < UINT16_MAX)
+                        runs.back().second++;
+                    else
+                        runs.emplace_back(type, 1);
+                }
+            }
+        }
+
+        detail::writeU32(out, static_cast<uint32_t>(coords.x));
+        detail::writeU32(out, static_cast<uint32_t>(coords.y));
+        detail::writeU32(out, static_cast<uint32_t>(runs.size()));
+        for (const auto &[type, length] : runs)
+        {
+            out.put(static_cast<char>(type));
+            detail::writeU16(out, length);
+        }
+    }
+
+    inline bool writeRegion(const std::string &path, uint32_t seed, const std::vector<ChunkEntry> &chunks)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            return false;
+        out.write(MAGIC, 4);
+        detail::writeU32(out, VERSION);
+        detail::writeU32(out, seed);
+        detail::writeU32(out, static_cast<uint32_t>(chunks.size()));
+        for (const auto &[coords, chunk] : chunks)
+            writeChunk(out, coords, *chunk);
+        return static_cast<bool>(out);
+    }
+}
+
+#endif // WORLD_SAVE_H
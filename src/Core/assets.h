@@ -71,6 +71,9 @@ public:
         // Add your default shaders
         addShader("default", "resources/shaders/vertex_texture.glsl", "resources/shaders/fragment_texture.glsl");
         addShader("ui", "resources/shaders/vertex_2d.glsl", "resources/shaders/fragment_2d.glsl");
+        addShader("terrain", "resources/shaders/vertex_terrain.glsl", "resources/shaders/fragment_texture.glsl");
+        addShader("instanced", "resources/shaders/vertex_instanced.glsl", "resources/shaders/fragment_texture.glsl");
+        addShader("horizon", "resources/shaders/vertex_horizon.glsl", "resources/shaders/fragment_horizon.glsl");
         
         // Add your default textures
         addTexture("grass", "resources/textures/grass.png");
@@ -100,6 +100,15 @@ public:
         updateCameraVectors();
     }
 
+    // moves and turns the camera in one go, for scripted camera paths
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
     void ProcessMouseScroll(float yoffset)
     {
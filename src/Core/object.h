@@ -5,8 +5,6 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
-#include "transform.h"
-#include "Rendering/meshRenderer.h"
 #include "hierarchyMap.h"
 
 using namespace std;
@@ -169,37 +167,4 @@ private:
     vector<shared_ptr<Object>> Children;
 };
 
-class PVObject : public Object {
-public:
-    shared_ptr<Transform> transformPtr;
-    shared_ptr<UV_MeshRenderer> meshRendererPtr;
-    weak_ptr<Transform> transform;
-    weak_ptr<UV_MeshRenderer> meshRenderer;
-
-    PVObject(string name = "PVObject")
-        : Object(name) {
-        try {
-            ClassName = "PVObject";
-            AddAncestorClass("PVObject");
-
-            // First create the components
-            transformPtr = make_shared<Transform>();
-            if (!transformPtr) throw runtime_error("Failed to create Transform");
-            
-            meshRendererPtr = make_shared<UV_MeshRenderer>(transformPtr);
-            if (!meshRendererPtr) throw runtime_error("Failed to create MeshRenderer");
-            
-            // Assign weak pointers
-            transform = transformPtr;
-            meshRenderer = meshRendererPtr;
-
-        }
-        catch (const exception& e) {
-            // Clean up any allocated resources
-            transformPtr.reset();
-            meshRendererPtr.reset();
-            throw;  // Re-throw the exception
-        }
-    }
-};
 #endif // INSTANCE_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef PV_OBJECT_H
+#define PV_OBJECT_H
+
+#include "object.h"
+#include "transform.h"
+#include "Rendering/meshRenderer.h"
+
+// Object with a transform and a mesh renderer. Kept apart from object.h so the
+// object hierarchy itself stays usable without GL.
+class PVObject : public Object {
+public:
+    shared_ptr<Transform> transformPtr;
+    shared_ptr<UV_MeshRenderer> meshRendererPtr;
+    weak_ptr<Transform> transform;
+    weak_ptr<UV_MeshRenderer> meshRenderer;
+
+    PVObject(string name = "PVObject")
+        : Object(name) {
+        try {
+            ClassName = "PVObject";
+            AddAncestorClass("PVObject");
+
+            // First create the components
+            transformPtr = make_shared<Transform>();
+            if (!transformPtr) throw runtime_error("Failed to create Transform");
+            
+            meshRendererPtr = make_shared<UV_MeshRenderer>(transformPtr);
+            if (!meshRendererPtr) throw runtime_error("Failed to create MeshRenderer");
+            
+            // Assign weak pointers
+            transform = transformPtr;
+            meshRenderer = meshRendererPtr;
+
+        }
+        catch (const exception& e) {
+            // Clean up any allocated resources
+            transformPtr.reset();
+            meshRendererPtr.reset();
+            throw;  // Re-throw the exception
+        }
+    }
+};
+
+#endif // PV_OBJECT_H
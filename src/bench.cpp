@@ -0,0 +1,322 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/World/world.h"
+#include "Core/Block/blockDatabase.h"
+#include "Core/Math/frustrum.h"
+#include "Core/Util/AABB.h"
+#include "Core/Debug/traceRecorder.h"
+#include "Core/Debug/allocationTracker.h"
+
+// Microbenchmarks for the engine's hot paths. Runs without a window or GL context,
+// like voxelc-pregen. Each benchmark is calibrated until one repetition takes at
+// least --min-time, warmed up once, then timed --reps times; min and median ns/op
+// are reported with the heap bytes and allocations of one operation.
+
+namespace
+{
+    // Every operator new on any thread, whatever its tag; benchmarks run one at a
+    // time, so the difference across a repetition is what that repetition allocated
+    std::uint64_t getAllocatedBytes()
+    {
+        std::uint64_t total = 0;
+        for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+            total += AllocationTracker::getBytes(static_cast<AllocationTag>(tag));
+        return total;
+    }
+
+    std::uint64_t getAllocationCount()
+    {
+        std::uint64_t total = 0;
+        for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+            total += AllocationTracker::getCount(static_cast<AllocationTag>(tag));
+        return total;
+    }
+
+    // Results are folded in here so the optimizer can't drop the work
+    volatile double sink = 0.0;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchResult
+    {
+        std::string name;
+        std::size_t iterations = 0; // Per repetition
+        int repetitions = 0;
+        double minNs = 0.0;
+        double medianNs = 0.0;
+        double bytesPerOp = 0.0;
+        double allocsPerOp = 0.0;
+    };
+
+    struct BenchOptions
+    {
+        int repetitions = 9;
+        double minTimeMs = 20.0;
+        std::string filter;
+    };
+
+    // `op(i)` performs one operation; i counts up so benchmarks can cycle through inputs
+    using BenchOp = std::function<void(std::size_t)>;
+
+    double runBatch(const BenchOp &op, std::size_t iterations)
+    {
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < iterations; i++)
+            op(i);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    BenchResult runBenchmark(const std::string &name, const BenchOp &op, const BenchOptions &options)
+    {
+        BenchResult result;
+        result.name = name;
+        result.repetitions = options.repetitions;
+
+        // Calibrate: double the batch until it runs long enough to time reliably.
+        // This also warms caches, the allocator and the branch predictors.
+        std::size_t iterations = 1;
+        const double minTimeNs = options.minTimeMs * 1.0e6;
+        while (runBatch(op, iterations) < minTimeNs && iterations < (std::size_t(1) << 30))
+            iterations *= 2;
+        result.iterations = iterations;
+        runBatch(op, iterations);
+
+        std::vector<double> nsPerOp;
+        for (int rep = 0; rep < options.repetitions; rep++)
+        {
+            std::uint64_t bytesBefore = getAllocatedBytes();
+            std::uint64_t countBefore = getAllocationCount();
+            nsPerOp.push_back(runBatch(op, iterations) / iterations);
+            if (rep == 0)
+            {
+                result.bytesPerOp = double(getAllocatedBytes() - bytesBefore) / iterations;
+                result.allocsPerOp = double(getAllocationCount() - countBefore) / iterations;
+            }
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        result.minNs = nsPerOp.front();
+        result.medianNs = nsPerOp[nsPerOp.size() / 2];
+        return result;
+    }
+
+    bool writeResults(const std::string &path, const std::vector<BenchResult> &results, unsigned int seed)
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        char line[256];
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        if (csv)
+        {
+            out << "name,iterations,repetitions,min_ns,median_ns,bytes_per_op,allocs_per_op\n";
+            for (const auto &r : results)
+            {
+                std::snprintf(line, sizeof(line), "%s,%zu,%d,%.3f,%.3f,%.1f,%.3f\n", r.name.c_str(), r.iterations,
+                              r.repetitions, r.minNs, r.medianNs, r.bytesPerOp, r.allocsPerOp);
+                out << line;
+            }
+        }
+        else
+        {
+            out << "{\n  \"seed\": " << seed << ",\n  \"benchmarks\": [";
+            for (std::size_t i = 0; i < results.size(); i++)
+            {
+                const auto &r = results[i];
+                std::snprintf(line, sizeof(line),
+                              "%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"repetitions\": %d, \"min_ns\": %.3f, "
+                              "\"median_ns\": %.3f, \"bytes_per_op\": %.1f, \"allocs_per_op\": %.3f}",
+                              i > 0 ? "," : "", r.name.c_str(), r.iterations, r.repetitions, r.minNs, r.medianNs,
+                              r.bytesPerOp, r.allocsPerOp);
+                out << line;
+            }
+            out << "\n  ]\n}\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    // Small deterministic generator for benchmark inputs
+    struct InputRandom
+    {
+        std::uint32_t state = 0x12345678u;
+        std::uint32_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+        float range(float min, float max) { return min + (max - min) * (next() / 4294967296.0f); }
+    };
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: voxelc_bench [--filter TEXT] [--reps N] [--min-time MS] [--seed S] [--out path]\n"
+              << "  --filter TEXT  Only run benchmarks whose name contains TEXT\n"
+              << "  --reps N       Timed repetitions per benchmark (default 9)\n"
+              << "  --min-time MS  Minimum length of one repetition (default 20)\n"
+              << "  --seed S       World seed (default " << WorldGeneratorParams().seed << ")\n"
+              << "  --out path     Write results as JSON, or CSV if path ends in .csv\n";
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    WorldGeneratorParams params;
+    std::string outPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--reps" && hasValue)
+            options.repetitions = std::atoi(argv[++i]);
+        else if (arg == "--min-time" && hasValue)
+            options.minTimeMs = std::atof(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            params.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (options.repetitions <= 0 || options.minTimeMs <= 0.0)
+    {
+        std::cerr << "--reps and --min-time must be positive" << std::endl;
+        return 1;
+    }
+
+    // Block meshes are built from fixed tile coordinates; the atlas itself isn't read
+    BlockDatabase::initialize(nullptr);
+
+    // A small meshed world for the lookups and raycasts
+    const int WORLD_SIZE = 8;
+    World world(params, true);
+    world.generateTerrain(WORLD_SIZE, WORLD_SIZE);
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    for (const auto &entry : world.getLoadedChunks())
+    {
+        entry.second->updateMesh();
+        chunks.push_back(entry.second);
+    }
+    // Chunks built here stay out of the world above
+    WorldGenerator generator(params);
+    generator.setHeadless(true);
+    PerlinNoise noise(params.seed);
+
+    InputRandom random;
+    const std::size_t INPUT_COUNT = 4096; // Inputs cycle with this period
+    const float worldExtent = WORLD_SIZE / 2 * Chunk::CHUNK_SIZE;
+
+    // Rays start above the terrain and head down at an angle, so most hit something
+    std::vector<glm::vec3> rayOrigins(INPUT_COUNT), rayDirections(INPUT_COUNT);
+    for (std::size_t i = 0; i < INPUT_COUNT; i++)
+    {
+        rayOrigins[i] = glm::vec3(random.range(-worldExtent, worldExtent) * 0.5f, params.maxHeight + 8.0f,
+                                  random.range(-worldExtent, worldExtent) * 0.5f);
+        rayDirections[i] = glm::normalize(glm::vec3(random.range(-1.0f, 1.0f), -1.0f, random.range(-1.0f, 1.0f)));
+    }
+    std::vector<AABB> boxes(INPUT_COUNT);
+    for (auto &box : boxes)
+    {
+        box.min = glm::vec3(random.range(-64.0f, 64.0f), random.range(-64.0f, 64.0f), random.range(-64.0f, 64.0f));
+        box.max = box.min + glm::vec3(random.range(1.0f, 16.0f));
+    }
+    std::vector<glm::vec3> spheres(INPUT_COUNT);
+    for (auto &center : spheres)
+        center = glm::vec3(random.range(-512.0f, 512.0f), random.range(0.0f, 256.0f), random.range(-512.0f, 512.0f));
+    Frustum frustum;
+    frustum.update(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 2048.0f) *
+                   glm::lookAt(glm::vec3(0.0f, 100.0f, 0.0f), glm::vec3(1.0f, 90.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    // Half of the lookups miss
+    std::vector<glm::ivec2> lookups(INPUT_COUNT);
+    for (auto &coords : lookups)
+        coords = glm::ivec2(random.next() % (WORLD_SIZE * 2), random.next() % (WORLD_SIZE * 2)) - glm::ivec2(WORLD_SIZE / 2);
+
+    std::vector<std::pair<std::string, BenchOp>> benchmarks;
+    benchmarks.push_back({"perlin.noise", [&](std::size_t i)
+                          {
+                              sink = sink + noise.noise(i * 0.173, 0.5, i * 0.091);
+                          }});
+    benchmarks.push_back({"generator.generateHeight", [&](std::size_t i)
+                          { sink = sink + generator.generateHeight(static_cast<int>(i % 1024), static_cast<int>(i / 1024 % 1024)); }});
+    benchmarks.push_back({"generator.generateChunk", [&](std::size_t i)
+                          {
+                              int x = static_cast<int>(i % 64) * Chunk::CHUNK_SIZE;
+                              int z = static_cast<int>(i / 64 % 64) * Chunk::CHUNK_SIZE;
+                              auto chunk = generator.generateChunk(nullptr, x, z, Chunk::CHUNK_SIZE, Chunk::CHUNK_SIZE);
+                              sink = sink + chunk->getHeightmap().getMaxSolid();
+                          }});
+    benchmarks.push_back({"chunk.updateMesh", [&](std::size_t i)
+                          {
+                              // An edit marks the mesh outdated, as it would in game
+                              auto &chunk = chunks[i % chunks.size()];
+                              chunk->setBlock(0, 0, 0, chunk->getBlock(0, 0, 0), false);
+                              chunk->updateMesh();
+                          }});
+    benchmarks.push_back({"spatialMesh.calculateBlockAABBs", [&](std::size_t i)
+                          { chunks[i % chunks.size()]->getSpatialMesh()->calculateBlockAABBs(1.0f); }});
+    benchmarks.push_back({"world.raycast", [&](std::size_t i)
+                          {
+                              BlockRaycastHit hit;
+                              std::size_t input = i % INPUT_COUNT;
+                              if (world.raycast(rayOrigins[input], rayDirections[input], 256.0f, hit))
+                                  sink = sink + hit.distance;
+                          }});
+    benchmarks.push_back({"aabb.raycast", [&](std::size_t i)
+                          {
+                              std::size_t input = i % INPUT_COUNT;
+                              AABBRaycastResult hit = boxes[input].raycast(glm::vec3(0.0f), rayDirections[input]);
+                              sink = sink + hit.tNear;
+                          }});
+    benchmarks.push_back({"frustum.isInFrustum", [&](std::size_t i)
+                          { sink = sink + frustum.isInFrustum(spheres[i % INPUT_COUNT], 16.0f); }});
+    benchmarks.push_back({"world.getChunk", [&](std::size_t i)
+                          {
+                              const glm::ivec2 &coords = lookups[i % INPUT_COUNT];
+                              sink = sink + (world.getChunk(coords.x, coords.y) != nullptr);
+                          }});
+    // One empty span: two clock reads and a ring write
+    benchmarks.push_back({"trace.scope", [&](std::size_t)
+                          { VOXELC_TRACE_SCOPE("bench", "bench"); }});
+
+    std::vector<BenchResult> results;
+    std::printf("%-34s %12s %12s %12s %10s\n", "benchmark", "min ns/op", "median ns/op", "bytes/op", "allocs/op");
+    for (const auto &[name, op] : benchmarks)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            continue;
+        // Only the trace benchmark records; the rest measure the code without it
+        TraceRecorder::setEnabled(name.rfind("trace.", 0) == 0);
+        BenchResult result = runBenchmark(name, op, options);
+        std::printf("%-34s %12.1f %12.1f %12.1f %10.2f\n", result.name.c_str(), result.minNs, result.medianNs,
+                    result.bytesPerOp, result.allocsPerOp);
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (!outPath.empty())
+    {
+        if (!writeResults(outPath, results, params.seed))
+        {
+            std::cerr << "Failed to write " << outPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << outPath << std::endl;
+    }
+    return 0;
+}
@@ -6,6 +6,10 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
 #include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
 
 #include "Core/Rendering/meshRenderer.h"
 #include "Core/Rendering/mesh.h"
@@ -18,7 +22,17 @@
 #include "Core/assets.h"
 #include "Core/World/chunk.h"
 #include "Core/Renderer/renderer.h"
+#include "Core/Renderer/chunkRenderer.h"
 #include "Core/Renderer/renderer2D.h"
+#include "Core/Renderer/textRenderer.h"
+#include "Core/Debug/frameProfiler.h"
+#include "Core/Debug/debugOverlay.h"
+#include "Core/Debug/cameraPath.h"
+#include "Core/Debug/benchmarkReport.h"
+#include "Core/Debug/traceRecorder.h"
+#include "Core/Debug/metrics.h"
+#include "Core/Debug/allocationTracker.h"
+#include "Core/Renderer/occlusionCuller.h"
 #include "Core/Block/blockDatabase.h"
 #include "Core/Input/InputManager.h"
 
@@ -34,11 +48,18 @@ void processInput(GLFWwindow *window);
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
-const unsigned int RENDER_DISTANCE = 16 * 16;
+const unsigned int RENDER_DISTANCE = 64 * 16; // Far chunks are streamed in at reduced detail; the F3 panel can change it
+const float STARTUP_RADIUS = 5 * 16; // Area streamed in around the spawn point
+const char *DEFAULT_BENCHMARK_PATH = "resources/benchmarks/default_flythrough.txt";
+const float BENCHMARK_STEP = 1.0f / 60.0f; // Path time per benchmark frame, however long the frame takes
+const float RECORD_INTERVAL = 0.25f;       // Seconds between keyframes written by --record-path
+const double TRACE_SECONDS = 10.0;         // Default span of a trace dump
+const double METRICS_INTERVAL = 1.0;       // Default seconds between --metrics dumps
 // UI Renderer
 // std::shared_ptr<UIRenderer> uiRenderer = nullptr;
 std::shared_ptr<Renderer> renderer = nullptr;
 std::shared_ptr<Renderer2D> uiRenderer = nullptr;
+std::shared_ptr<TextRenderer> textRenderer = nullptr;
 
 // timing
 float deltaTime = 0.0f; // time between current frame and last frame
@@ -49,28 +70,145 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 Frustum viewFrustum;
+OcclusionCuller occlusionCuller;
+FrameProfiler frameProfiler; // Only times anything while the F3 panel is up or a benchmark runs
 
 bool mouseLocked = true;
 
-int main()
+static void printUsage()
 {
+    std::cout << "Usage: voxelc [--headless] [--width W] [--height H] [--frames N] [--seed S]\n"
+              << "              [--benchmark [PATH]] [--report FILE] [--record-path FILE]\n"
+              << "              [--trace FILE] [--trace-seconds N] [--metrics FILE] [--metrics-interval S]\n"
+              << "              [--occlusion on|off]\n"
+              << "  --headless          Render offscreen from an invisible window, no vsync or frame cap\n"
+              << "  --width W           Framebuffer width (default " << SCR_WIDTH << ")\n"
+              << "  --height H          Framebuffer height (default " << SCR_HEIGHT << ")\n"
+              << "  --frames N          Exit after N frames, 0 = run until closed (default 0)\n"
+              << "  --seed S            World seed (default " << WorldGeneratorParams().seed << ")\n"
+              << "  --benchmark [PATH]  Fly a camera path uncapped and report frame times, then exit\n"
+              << "                      (default " << DEFAULT_BENCHMARK_PATH << ")\n"
+              << "  --report FILE       Benchmark report, CSV if FILE ends in .csv (default benchmark.json)\n"
+              << "  --record-path FILE  Save the camera's movement as a path for --benchmark on exit\n"
+              << "  --trace FILE        Write the last seconds of the timeline as Chrome trace JSON on exit\n"
+              << "  --trace-seconds N   Seconds kept by --trace and F4 dumps (default " << TRACE_SECONDS << ")\n"
+              << "  --metrics FILE      Keep FILE updated with every metric as JSON, e.g. /dev/shm/voxelc.json\n"
+              << "  --metrics-interval S  Seconds between metrics dumps (default " << METRICS_INTERVAL << ")\n"
+              << "  --occlusion on|off  Start with software occlusion culling on or off (default on, O toggles)\n";
+}
+
+int main(int argc, char **argv)
+{
+    bool headless = false;
+    unsigned int width = SCR_WIDTH, height = SCR_HEIGHT;
+    long frameLimit = 0;
+    WorldGeneratorParams worldParams;
+    bool benchmarking = false;
+    std::string benchmarkPath = DEFAULT_BENCHMARK_PATH;
+    std::string reportPath = "benchmark.json";
+    std::string recordPath;
+    std::string tracePath;
+    double traceSeconds = TRACE_SECONDS;
+    std::string metricsPath;
+    double metricsInterval = METRICS_INTERVAL;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--width" && hasValue)
+            width = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--height" && hasValue)
+            height = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--frames" && hasValue)
+            frameLimit = std::atol(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            worldParams.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--benchmark")
+        {
+            benchmarking = true;
+            if (hasValue && std::string(argv[i + 1]).rfind("--", 0) != 0)
+                benchmarkPath = argv[++i];
+        }
+        else if (arg == "--report" && hasValue)
+            reportPath = argv[++i];
+        else if (arg == "--record-path" && hasValue)
+            recordPath = argv[++i];
+        else if (arg == "--trace" && hasValue)
+            tracePath = argv[++i];
+        else if (arg == "--trace-seconds" && hasValue)
+            traceSeconds = std::atof(argv[++i]);
+        else if (arg == "--metrics" && hasValue)
+            metricsPath = argv[++i];
+        else if (arg == "--metrics-interval" && hasValue)
+            metricsInterval = std::atof(argv[++i]);
+        else if (arg == "--occlusion" && hasValue && (std::string(argv[i + 1]) == "on" || std::string(argv[i + 1]) == "off"))
+            occlusionCuller.setEnabled(std::string(argv[++i]) == "on");
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (width == 0 || height == 0)
+    {
+        std::cerr << "--width and --height must be positive" << std::endl;
+        return 1;
+    }
+    if (metricsInterval <= 0.0)
+    {
+        std::cerr << "--metrics-interval must be positive" << std::endl;
+        return 1;
+    }
+    CameraPath cameraPath;
+    if (benchmarking && !cameraPath.load(benchmarkPath))
+        return 1;
+
+    // Recording is cheap enough to leave on, so F4 can capture a hitch after it happened
+    TraceRecorder::setEnabled(true);
+    TraceRecorder::setThreadName("Main");
+    // Heap use per subsystem, counted by this program's operator new
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+    {
+        std::string name = std::string("alloc.") + AllocationTracker::getTagName(static_cast<AllocationTag>(tag));
+        Metrics::addCounterSource(name + ".bytes", [tag]() { return AllocationTracker::getBytes(static_cast<AllocationTag>(tag)); });
+        Metrics::addCounterSource(name + ".count", [tag]() { return AllocationTracker::getCount(static_cast<AllocationTag>(tag)); });
+    }
+    // Written from its own thread; the frame loop only bumps counters
+    MetricsReporter metricsReporter;
+    if (!metricsPath.empty())
+        metricsReporter.start(metricsPath, metricsInterval);
+
+    auto startupBegin = std::chrono::steady_clock::now();
+    auto secondsSinceStartup = [startupBegin]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startupBegin).count();
+    };
 
     renderer = std::make_shared<Renderer>();
+    renderer->setHeadless(headless);
+    renderer->setScrSize(width, height);
     renderer->initialize();
+    // Benchmarks measure how fast frames can be made, not the display's refresh rate
+    if (benchmarking)
+        glfwSwapInterval(0);
+    // Fog ends with the horizon terrain rather than with the chunks
+    renderer->setFog(glm::vec3(186.0f / 255.0f, 214.0f / 255.0f, 254.0f / 255.0f), HorizonRenderer::getOuterRadius());
 
     GLFWwindow *window = renderer->getWindow();
     // Set up OpenGL callbacks related to input
     // glfwSetCursorPosCallback(window, mouse_callback);
     // glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!headless)
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     InputManager::initialize(window);
 
 
     // Set up OpenGL options
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    renderer->enableCapability(GL_DEPTH_TEST);
+    renderer->enableCapability(GL_BLEND);
+    renderer->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     assetMgr.initializeDefaultAssets();
     if (assetMgr.getTextureAtlas("terrain_atlas"))
@@ -79,20 +217,77 @@ int main()
     // Initialize UI Renderer
     uiRenderer = std::make_shared<Renderer2D>();
     uiRenderer->setShader(assetMgr.getShader("ui"));
-    uiRenderer->setProjection(glm::ortho(0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f));
+    // No font ships with the game; the debug text stays hidden when none of these exist
+    textRenderer = std::make_shared<TextRenderer>();
+    for (const char *fontPath : {"resources/fonts/default.ttf", "C:/Windows/Fonts/consola.ttf",
+                                 "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+                                 "/System/Library/Fonts/Menlo.ttc"})
+    {
+        if (textRenderer->loadFont(fontPath, 16))
+            break;
+    }
+    if (!textRenderer->hasFont())
+        std::cerr << "No font found; debug text disabled" << std::endl;
+    std::string debugText;
+    double debugTextTime = 0.0;
+    int debugTextFrames = 0;
 
     // std::shared_ptr<Texture> texture0 = assetMgr.getTexture("grass");
     // std::shared_ptr<Texture> texture1 = assetMgr.addTexture("block", "resources/textures/block_sample.png");
     // Shader shader("resources/shaders/vertex_texture.glsl", "resources/shaders/fragment_texture.glsl");
     std::shared_ptr<Shader> shader = assetMgr.getShader("default");
     renderer->setShader(shader);
-    std::shared_ptr<World> world = std::make_shared<World>();
+    // Repeated meshes drawn with "default" go out as instances through its twin
+    renderer->setInstancedShader(assetMgr.getShader("instanced"));
+    std::shared_ptr<World> world = std::make_shared<World>(worldParams);
     auto root = world->getRoot();
+    auto terrain = renderer->getTerrainRenderer();
+    if (terrain)
+        terrain->setMaterial(assetMgr.getShader("terrain"), assetMgr.getTexture("terrain"));
+    // Staging and drawing chunk meshes is the renderer's side; the world only builds them
+    auto chunkRenderer = std::make_shared<ChunkRenderer>(terrain ? terrain->getUploadRing() : nullptr);
+    world->setMeshListener(chunkRenderer);
+    // Past the chunks, the horizon reads surface heights straight from the generator
+    auto horizon = renderer->getHorizonRenderer();
+    horizon->setMaterial(assetMgr.getShader("horizon"), assetMgr.getTexture("terrain"));
+    float renderDistance = static_cast<float>(RENDER_DISTANCE);
+    horizon->setInnerRadius(renderDistance / 2.0f);
+    horizon->setSampler([generator = &world->getGenerator()](int x, int z)
+                        {
+                            int height;
+                            BlockType block = generator->sampleSurface(x, z, height);
+                            return HorizonSample{static_cast<float>(height), static_cast<int>(block)}; });
 
     std::atomic<bool> shouldStop{false};
 
-    // Generate terrain on main thread first
-    world->generateTerrain(8,8);
+    // Spawn on top of the terrain instead of inside it; benchmarks start where their path does
+    if (benchmarking)
+    {
+        CameraKeyframe start = cameraPath.sample(0.0f);
+        camera.SetPose(start.position, start.yaw, start.pitch);
+    }
+    else
+        camera.Position.y = static_cast<float>(world->getSurfaceHeight(0, 0)) + 2.0f;
+
+    // Stream the starting area in the background so the first frame isn't blocked on it;
+    // the main loop reprioritizes the queue around the camera every frame
+    world->startStreaming();
+    world->requestArea(camera.Position, STARTUP_RADIUS);
+    bool loggedFirstFrame = false;
+    bool loggedStartupArea = false;
+
+    const int stageStreaming = frameProfiler.addStage("updateStreaming");
+    const int stageTick = frameProfiler.addStage("tickUpdate");
+    const int stageVisible = frameProfiler.addStage("getVisibleChunks");
+    const int stageOcclusion = frameProfiler.addStage("occlusion cull");
+    const int stageQueue = frameProfiler.addStage("queueToRenderer");
+    const int stageEndFrame = frameProfiler.addStage("endFrame");
+    const int stageUi = frameProfiler.addStage("UI");
+    const int stageSwap = frameProfiler.addStage("swap");
+    DebugOverlay overlay(textRenderer, frameProfiler);
+    const int sliderDistance = overlay.addSlider("Render distance", renderDistance, 128.0f, 2048.0f, 64.0f);
+    const int sliderWorkers = overlay.addSlider("Worker threads", static_cast<float>(world->getStreamingThreadCount()), 1.0f,
+                                                static_cast<float>(std::max(1u, std::thread::hardware_concurrency())), 1.0f);
 
 
     InputManager::onKeyPressed([window](int key) {
@@ -132,7 +327,7 @@ int main()
                     int localX = x - chunkX * Chunk::CHUNK_SIZE;
                     int localY = y;
                     int localZ = z - chunkZ * Chunk::CHUNK_SIZE;
-                    chunk->setBlock(localX, localY, localZ, BLOCK_TYPE_STONE);
+                    chunk->editBlock(localX, localY, localZ, BLOCK_TYPE_STONE);
                 }
             }
         }
@@ -163,7 +358,7 @@ int main()
                     int localX = x - chunkX * Chunk::CHUNK_SIZE;
                     int localY = y;
                     int localZ = z - chunkZ * Chunk::CHUNK_SIZE;
-                    chunk->setBlock(localX, localY, localZ, BLOCK_TYPE_AIR);
+                    chunk->editBlock(localX, localY, localZ, BLOCK_TYPE_AIR);
                 }
             }
         }
@@ -194,13 +389,40 @@ int main()
                     int localX = x - chunkX * Chunk::CHUNK_SIZE;
                     int localY = y;
                     int localZ = z - chunkZ * Chunk::CHUNK_SIZE;
-                    chunk->setBlock(localX, localY, localZ, BLOCK_TYPE_AIR);
+                    chunk->editBlock(localX, localY, localZ, BLOCK_TYPE_AIR);
                 }
             }
         }
     }});
 
 
+    // F3 shows the performance panel; its sliders need the cursor freed with Escape
+    bool showOverlay = false;
+    frameProfiler.setEnabled(benchmarking);
+    InputManager::onKeyPressed([&showOverlay, benchmarking](int key) {
+        if (key == GLFW_KEY_F3) {
+        showOverlay = !showOverlay;
+        frameProfiler.setEnabled(showOverlay || benchmarking);
+    }});
+
+    // F4 saves the recent timeline of every thread for chrome://tracing or Perfetto
+    int traceDumps = 0;
+    InputManager::onKeyPressed([&traceDumps, traceSeconds](int key) {
+        if (key == GLFW_KEY_F4) {
+        std::string path = "trace_" + std::to_string(++traceDumps) + ".json";
+        if (TraceRecorder::write(path, traceSeconds))
+            std::cout << "Trace of the last " << traceSeconds << "s written to " << path << std::endl;
+        else
+            std::cerr << "Failed to write trace " << path << std::endl;
+    }});
+
+    // O toggles software occlusion culling for A/B comparisons
+    InputManager::onKeyPressed([](int key) {
+        if (key == GLFW_KEY_O) {
+        occlusionCuller.setEnabled(!occlusionCuller.isEnabled());
+        std::cout << "Occlusion culling " << (occlusionCuller.isEnabled() ? "on" : "off") << std::endl;
+    }});
+
     InputManager::onScroll([](double xoffset, double yoffset) {
         if (InputManager::isMouseLocked() || InputManager::isMouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT)) {
             camera.ProcessMouseScroll(yoffset);
@@ -260,20 +482,41 @@ int main()
     // ImGui globals
     bool explorerActive = false;
 
+    // Benchmarks wait for the starting area, then step along the path a fixed amount
+    // per frame, so every run renders the same poses however fast it goes. Every pose
+    // also waits, untimed, for the whole render distance around it to stream in.
+    BenchmarkReport benchmarkReport;
+    long benchmarkFrames = 0;
+    std::size_t benchmarkStartChunks = 0;
+    double streamingWaitSeconds = 0.0;
+    std::size_t visibleChunkCount = 0;
+    CameraPath recordedPath;
+    double recordStart = glfwGetTime();
+    double lastRecordTime = -RECORD_INTERVAL;
+
     // Main rendering loop
-    while (!glfwWindowShouldClose(window))
+    long frameCount = 0;
+    double loopStart = glfwGetTime();
+    while (!renderer->shouldClose() && (frameLimit <= 0 || frameCount < frameLimit))
     {
+        frameCount++;
+        VOXELC_TRACE_SCOPE("frame", "main");
+        static MetricHistogram &frameTimes = Metrics::histogram("frame.time_us");
 
         // per-frame time logic
         // --------------------
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        // Start to start, so it's the frame time the player sees, cap included
+        if (frameCount > 1)
+            frameTimes.record(static_cast<std::uint64_t>(deltaTime * 1.0e6f));
 
         double currentTime = glfwGetTime();
         double elapsedTime = currentTime - lastFrameTime;
 
-        if (deltaTime < frameTime)
+        // Headless runs and benchmarks measure throughput, so they never wait
+        if (!headless && !benchmarking && deltaTime < frameTime)
         {
             double sleepTime = frameTime - deltaTime;
             std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
@@ -291,38 +534,210 @@ int main()
         // glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        world->tickUpdate();
+        if (benchmarking && loggedStartupArea)
+        {
+            float pathTime = benchmarkFrames * BENCHMARK_STEP;
+            if (pathTime > cameraPath.getDuration())
+                break;
+            CameraKeyframe pose = cameraPath.sample(pathTime);
+            camera.SetPose(pose.position, pose.yaw, pose.pitch);
+
+            auto waitStart = FrameProfiler::Clock::now();
+            world->updateStreaming(camera.Position, renderDistance);
+            world->finishPendingChunks();
+            frameProfiler.excludeSince(waitStart);
+            double waited = std::chrono::duration<double>(FrameProfiler::Clock::now() - waitStart).count();
+            if (benchmarkFrames == 0)
+            {
+                benchmarkStartChunks = world->getLoadedChunkCount();
+                std::cout << "Benchmark: " << benchmarkStartChunks << " chunks streamed in around the path start after "
+                          << waited << "s" << std::endl;
+            }
+            else
+                streamingWaitSeconds += waited;
+            benchmarkFrames++;
+        }
+        if (!recordPath.empty() && currentTime - lastRecordTime >= RECORD_INTERVAL)
+        {
+            recordedPath.addKeyframe({static_cast<float>(currentTime - recordStart), camera.Position, camera.Yaw, camera.Pitch});
+            lastRecordTime = currentTime;
+        }
 
         glm::mat4 view = camera.GetViewMatrix();
+        viewFrustum.update(renderer->getProjectionMatrix() * view);
 
-        auto chunks = world->getChunksInRange(camera.Position, RENDER_DISTANCE);
+        frameProfiler.nextFrame();
+        // The frame just closed was on the path too once the second path frame starts
+        if (benchmarkFrames >= 2)
+            benchmarkReport.addFrame(frameProfiler, world->getLoadedChunkCount(), visibleChunkCount, renderer->getFrameStats());
+        // Past the starting area, keep the loaded ring and its detail levels following the camera
+        {
+            auto timer = frameProfiler.scope(stageStreaming);
+            AllocationScope allocations(ALLOC_WORLD);
+            VOXELC_TRACE_SCOPE("updateStreaming", "main");
+            if (loggedStartupArea)
+                world->updateStreaming(camera.Position, renderDistance);
+            world->prioritizeRequests(camera.Position, viewFrustum);
+        }
+        {
+            auto timer = frameProfiler.scope(stageTick);
+            AllocationScope allocations(ALLOC_WORLD);
+            VOXELC_TRACE_SCOPE("tickUpdate", "main");
+            world->tickUpdate();
+        }
 
-        renderer->beginFrame(view);
-        // Find any descendants of the root object that is a PVObject and render them
-        for (const auto &chunk : chunks)
+        std::vector<std::shared_ptr<Chunk>> chunks;
         {
-            if (!chunk->isReady())
-                continue;
-            chunk->queueToRenderer(renderer);
+            auto timer = frameProfiler.scope(stageVisible);
+            AllocationScope allocations(ALLOC_WORLD);
+            VOXELC_TRACE_SCOPE("getVisibleChunks", "main");
+            chunks = world->getVisibleChunks(camera.Position, renderDistance, viewFrustum);
+            visibleChunkCount = chunks.size();
         }
-        renderer->endFrame();
-
-        glDisable(GL_DEPTH_TEST);
-        glDepthMask(GL_TRUE);
-        glDisable(GL_CULL_FACE);
-        uiRenderer->beginFrame();
-        // Render UI elements here
-        // uiRenderer->drawQuad(glm::vec2(0.0f, 0.0f), glm::vec2(320,320), assetMgr.getTexture("placeholder"), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-        uiRenderer->drawQuad(glm::vec2((float)SCR_WIDTH/2-20, (float)SCR_HEIGHT/2-20), glm::vec2(40,40), assetMgr.getTexture("crosshair"), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-        uiRenderer->endFrame();
-        glEnable(GL_DEPTH_TEST);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        // input
-        // -----
-        InputManager::pollEvents();
-        processInput(window);
+        {
+            auto timer = frameProfiler.scope(stageOcclusion);
+            AllocationScope allocations(ALLOC_RENDER);
+            VOXELC_TRACE_SCOPE("occlusion cull", "main");
+            occlusionCuller.cull(chunks, renderer->getProjectionMatrix() * view, camera.Position);
+        }
+
+        {
+            auto timer = frameProfiler.scope(stageQueue);
+            AllocationScope allocations(ALLOC_RENDER);
+            VOXELC_TRACE_SCOPE("queueToRenderer", "main");
+            renderer->beginFrame(view);
+            // Find any descendants of the root object that is a PVObject and render them
+            for (const auto &chunk : chunks)
+            {
+                if (!chunk->isReady())
+                    continue;
+                chunkRenderer->queue(*chunk, renderer);
+            }
+        }
+        {
+            auto timer = frameProfiler.scope(stageEndFrame);
+            AllocationScope allocations(ALLOC_RENDER);
+            VOXELC_TRACE_SCOPE("endFrame", "main");
+            renderer->endFrame();
+        }
+
+        {
+            auto timer = frameProfiler.scope(stageUi);
+            AllocationScope allocations(ALLOC_RENDER);
+            VOXELC_TRACE_SCOPE("UI", "main");
+            renderer->beginPass(RENDER_PASS_UI);
+            renderer->disableCapability(GL_DEPTH_TEST);
+            renderer->setDepthMask(true);
+            renderer->disableCapability(GL_CULL_FACE);
+            uiRenderer->beginFrame();
+            // Render UI elements here
+            // uiRenderer->drawQuad(glm::vec2(0.0f, 0.0f), glm::vec2(320,320), assetMgr.getTexture("placeholder"), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            auto [screenWidth, screenHeight] = renderer->getScrSize();
+            uiRenderer->drawQuad(glm::vec2((float)screenWidth/2-20, (float)screenHeight/2-20), glm::vec2(40,40), assetMgr.getTexture("crosshair"), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+            // Refreshed a few times a second, so most frames reuse the cached layout
+            debugTextFrames++;
+            if (currentTime - debugTextTime >= 0.25)
+            {
+                char line[256];
+                std::snprintf(line, sizeof(line), "FPS: %.0f\nXYZ: %.1f %.1f %.1f\nChunks: %zu loaded, %zu drawn",
+                              debugTextFrames / (currentTime - debugTextTime), camera.Position.x, camera.Position.y,
+                              camera.Position.z, world->getLoadedChunkCount(), chunks.size());
+                debugText = line;
+                debugTextTime = currentTime;
+                debugTextFrames = 0;
+            }
+            textRenderer->beginFrame();
+            if (showOverlay)
+            {
+                overlay.setStats({world->getLoadedChunkCount(), static_cast<std::size_t>(world->getGeneratingChunkCount()),
+                                  world->getQueuedChunkCount(), chunks.size()});
+                overlay.setRenderStats(renderer->getFrameStats());
+                bool dragging = !InputManager::isMouseLocked() && InputManager::isMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT);
+                overlay.draw(*uiRenderer, InputManager::getMousePosition(), dragging);
+                if (overlay.wasSliderReleased(sliderDistance))
+                {
+                    renderDistance = overlay.getSliderValue(sliderDistance);
+                    horizon->setInnerRadius(renderDistance / 2.0f);
+                }
+                if (overlay.wasSliderReleased(sliderWorkers))
+                    world->restartStreaming(static_cast<unsigned int>(overlay.getSliderValue(sliderWorkers)));
+            }
+            else
+            {
+                textRenderer->drawText(*uiRenderer, debugText, glm::vec2(8.0f, 8.0f));
+            }
+            uiRenderer->endFrame();
+            renderer->enableCapability(GL_DEPTH_TEST);
+            renderer->endPass(RENDER_PASS_UI);
+        }
+
+        {
+            auto timer = frameProfiler.scope(stageSwap);
+            renderer->present();
+        }
+        if (!loggedFirstFrame)
+        {
+            loggedFirstFrame = true;
+            std::cout << "Startup: first frame after " << secondsSinceStartup() << "s" << std::endl;
+        }
+        if (!loggedStartupArea && world->getPendingChunkCount() == 0)
+        {
+            loggedStartupArea = true;
+            std::cout << "Startup: starting radius (" << world->getLoadedChunkCount() << " chunks) ready after "
+                      << secondsSinceStartup() << "s" << std::endl;
+        }
+        {
+            VOXELC_TRACE_SCOPE("input", "input");
+            glfwPollEvents();
+            // input
+            // -----
+            InputManager::pollEvents();
+            processInput(window);
+        }
+    }
+    if (headless)
+    {
+        double seconds = glfwGetTime() - loopStart;
+        std::cout << "Rendered " << frameCount << " frames at " << width << "x" << height << " in " << seconds << "s ("
+                  << (seconds > 0.0 ? frameCount / seconds : 0.0) << " frames/sec)" << std::endl;
+    }
+    int exitCode = 0;
+    if (benchmarking)
+    {
+        BenchmarkInfo info{benchmarkPath, worldParams.seed, width, height, renderDistance,
+                           occlusionCuller.isEnabled(), benchmarkStartChunks, streamingWaitSeconds};
+        std::cout << "Benchmark: " << benchmarkReport.getSummary() << std::endl;
+        std::cout << "Benchmark: streaming settled before every frame, " << streamingWaitSeconds
+                  << "s spent waiting for chunks along the path (not timed)" << std::endl;
+        if (benchmarkReport.getFrameCount() == 0)
+        {
+            std::cerr << "Benchmark ended before the camera path started" << std::endl;
+            exitCode = 1;
+        }
+        else if (!benchmarkReport.write(reportPath, info))
+        {
+            std::cerr << "Failed to write benchmark report " << reportPath << std::endl;
+            exitCode = 1;
+        }
+        else
+            std::cout << "Benchmark report written to " << reportPath << std::endl;
+    }
+    if (!tracePath.empty())
+    {
+        if (TraceRecorder::write(tracePath, traceSeconds))
+            std::cout << "Trace of the last " << traceSeconds << "s written to " << tracePath << std::endl;
+        else
+        {
+            std::cerr << "Failed to write trace " << tracePath << std::endl;
+            exitCode = 1;
+        }
+    }
+    if (!recordPath.empty())
+    {
+        if (recordedPath.save(recordPath))
+            std::cout << "Camera path (" << recordedPath.getKeyframeCount() << " keyframes) saved to " << recordPath << std::endl;
+        else
+            std::cerr << "Failed to save camera path " << recordPath << std::endl;
     }
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
@@ -335,14 +750,20 @@ int main()
     try
     {
         shouldStop.store(true);
+        horizon->setSampler(nullptr); // Its background jobs read from the world
         world.reset();
+        textRenderer.reset();
+        // Everything holding GL objects goes while the context still exists
+        chunkRenderer.reset();
+        terrain.reset();
+        horizon.reset();
         renderer->cleanup();
     }
     catch (const std::exception &e)
     {
         std::cerr << e.what() << std::endl;
     }
-    return 0;
+    return exitCode;
 }
 
 static bool escPressedLastFrame = false;
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include "Core/World/world.h"
+#include "Core/World/worldSave.h"
+
+// Headless pre-generation tool: bakes an N x N chunk region with every core
+// and writes it to a region file. No window or GL context is created.
+
+static void printUsage()
+{
+    std::cout << "Usage: voxelc-pregen [--size N] [--seed S] [--threads T] [--out path]\n"
+              << "  --size N     Region width/depth in chunks (default 32)\n"
+              << "  --seed S     World seed (default " << WorldGeneratorParams().seed << ")\n"
+              << "  --threads T  Worker threads, 0 = all cores (default 0)\n"
+              << "  --out path   Output region file (default world.vxcw)\n";
+}
+
+int main(int argc, char **argv)
+{
+    int size = 32;
+    unsigned int threads = 0;
+    std::string outPath = "world.vxcw";
+    WorldGeneratorParams params;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue)
+            size = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)
+            params.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && hasValue)
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (size <= 0)
+    {
+        std::cerr << "--size must be positive" << std::endl;
+        return 1;
+    }
+
+    World world(params, true);
+    if (threads > 0)
+        world.setWorkerCount(threads);
+
+    std::cout << "Generating " << size << "x" << size << " chunks with seed " << params.seed
+              << " on " << world.getWorkerCount() << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    int lastPercent = -1;
+    world.generateTerrain(size, size, [&lastPercent](int done, int total)
+                          {
+        int percent = done * 100 / total;
+        if (percent != lastPercent)
+        {
+            lastPercent = percent;
+            std::cout << "\r  " << percent << "% (" << done << "/" << total << ")" << std::flush;
+        } });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::endl;
+
+    auto chunks = world.getLoadedChunks();
+    std::cout << "Generated " << chunks.size() << " chunks in " << seconds << "s ("
+              << (seconds > 0.0 ? chunks.size() / seconds : 0.0) << " chunks/sec)" << std::endl;
+
+    if (!WorldSave::writeRegion(outPath, world.getGenerator().getSeed(), chunks))
+    {
+        std::cerr << "Failed to write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << outPath << std::endl;
+    return 0;
+}